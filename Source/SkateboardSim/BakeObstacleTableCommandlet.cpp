@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakeObstacleTableCommandlet.h"
+#include "ObstacleTable.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBakeObstacleTable, Log, All);
+
+UBakeObstacleTableCommandlet::UBakeObstacleTableCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UBakeObstacleTableCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapsParam;
+	if (!FParse::Value(*Params, TEXT("Maps="), MapsParam, false))
+	{
+		UE_LOG(LogBakeObstacleTable, Error, TEXT("Usage: -run=BakeObstacleTable -Maps=/Game/Path/Map1+/Game/Path/Map2"));
+		return 1;
+	}
+
+	TArray<FString> MapNames;
+	MapsParam.ParseIntoArray(MapNames, TEXT("+"));
+
+	int32 NumFailed = 0;
+	for (const FString& MapName : MapNames)
+	{
+		UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+		UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (!World)
+		{
+			UE_LOG(LogBakeObstacleTable, Error, TEXT("Could not load map %s."), *MapName);
+			++NumFailed;
+			continue;
+		}
+
+		// Component world transforms are only valid once the world has registered its components
+		const bool bInitializedWorld = !World->bIsWorldInitialized;
+		if (bInitializedWorld)
+		{
+			World->WorldType = EWorldType::Editor;
+			World->InitWorld(UWorld::InitializationValues()
+				.AllowAudioPlayback(false)
+				.CreatePhysicsScene(false)
+				.RequiresHitProxies(false)
+				.CreateNavigation(false)
+				.CreateAISystem(false)
+				.ShouldSimulatePhysics(false)
+				.SetTransactional(false));
+		}
+		World->UpdateWorldComponents(true, false);
+
+		FObstacleTable Table;
+		const bool bBuilt = Table.BuildFromLevel(World->PersistentLevel);
+
+		const FString Filename = FObstacleTable::GetTablePath(MapName);
+		if (!bBuilt)
+		{
+			UE_LOG(LogBakeObstacleTable, Error, TEXT("Could not bake %s, its obstacles need unique keys."), *MapName);
+			++NumFailed;
+		}
+		else if (Table.Save(Filename))
+		{
+			UE_LOG(LogBakeObstacleTable, Display, TEXT("Baked %d obstacles from %s to %s."), Table.Obstacles.Num(), *MapName, *Filename);
+
+			// The cook strips obstacles by the flag saved on them, so the map is saved with the table whenever a flag moved
+			if (Table.MarkBakedObstacles(World->PersistentLevel))
+			{
+				FSavePackageArgs SaveArgs;
+				SaveArgs.TopLevelFlags = RF_Standalone;
+				const FString PackageFilename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetMapPackageExtension());
+				if (!UPackage::SavePackage(Package, World, *PackageFilename, SaveArgs))
+				{
+					UE_LOG(LogBakeObstacleTable, Error, TEXT("Failed to save %s, its obstacles will not be stripped from the cook."), *PackageFilename);
+					++NumFailed;
+				}
+			}
+		}
+		else
+		{
+			UE_LOG(LogBakeObstacleTable, Error, TEXT("Failed to write %s."), *Filename);
+			++NumFailed;
+		}
+
+		if (bInitializedWorld)
+		{
+			World->CleanupWorld();
+		}
+	}
+
+	return NumFailed == 0 ? 0 : 1;
+#else
+	UE_LOG(LogBakeObstacleTable, Error, TEXT("BakeObstacleTable needs an editor build."));
+	return 1;
+#endif
+}
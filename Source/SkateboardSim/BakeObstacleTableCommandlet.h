@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BakeObstacleTableCommandlet.generated.h"
+
+/**
+ * Extracts every obstacle marked bBakeToTable into a flat table per level and resaves the map with the
+ * obstacles flagged as baked, which is what the cook strips them by. Run before cooking:
+ * UnrealEditor-Cmd SkateboardSim.uproject -run=BakeObstacleTable -Maps=/Game/ThirdPerson/Maps/TestingParkLevel
+ */
+UCLASS()
+class UBakeObstacleTableCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBakeObstacleTableCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -3,7 +3,13 @@
 
 #include "ObstacleActor.h"
 #include "ObstacleCollisionManager.h"
+#include "SkateSignificanceSubsystem.h"
+#include "ObstacleTable.h"
 #include "Components/BoxComponent.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/ComponentDelegateBinding.h"
+#include "Engine/World.h"
+#include "Hash/CityHash.h"
 
 // Sets default values
 AObstacleActor::AObstacleActor()
@@ -33,6 +39,26 @@ AObstacleActor::AObstacleActor()
 
 	FailCollision->SetHiddenInGame(false);
 	MainCollision->SetHiddenInGame(false);
+
+	ObstacleKey = 0;
+}
+
+void AObstacleActor::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	ObstacleKey = ComputeObstacleKey();
+}
+
+uint64 AObstacleActor::ComputeObstacleKey() const
+{
+	// Placed actor paths are unique and stable between sessions, unlike FName indices. A 32-bit hash of the
+	// name alone collides within a few tens of thousands of obstacles.
+	const FString Path = UWorld::RemovePIEPrefix(GetPathName());
+	const uint64 Key = CityHash64(reinterpret_cast<const char*>(*Path), Path.Len() * sizeof(TCHAR));
+
+	// 0 is score that does not come from an obstacle
+	return Key != 0 ? Key : 1;
 }
 
 // Called when the game starts or when spawned
@@ -52,6 +78,27 @@ void AObstacleActor::BeginPlay()
 
 	bHasCollided = false;
 	bFailZoneTriggered = false;
+
+	USkateSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<USkateSignificanceSubsystem>();
+	if (Significance && !bScoredByManager)
+	{
+		Significance->RegisterObstacle(this);
+	}
+}
+
+void AObstacleActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bScoredByManager && CollisionManager)
+	{
+		CollisionManager->RemoveObstacleActor(this);
+	}
+
+	if (USkateSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<USkateSignificanceSubsystem>())
+	{
+		Significance->UnregisterObstacle(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AObstacleActor::OnMainCollisionOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
@@ -92,7 +139,7 @@ void AObstacleActor::OnSuccessfulJump()
 {
 	if (CollisionManager)
 	{
-		CollisionManager->AddScore(PositiveObstaclePointValue);
+		CollisionManager->AddScore(PositiveObstaclePointValue, ObstacleKey);
 	}
 }
 
@@ -100,7 +147,7 @@ void AObstacleActor::OnFailedJump()
 {
 	if (CollisionManager)
 	{
-		CollisionManager->SubtractScore(NegativeObstaclePointValue);
+		CollisionManager->SubtractScore(NegativeObstaclePointValue, ObstacleKey);
 	}
 }
 
@@ -117,3 +164,169 @@ void AObstacleActor::ResetOverlapFlags()
 	UE_LOG(LogTemp, Warning, TEXT("Flags reset after overlap."));
 }
 
+void AObstacleActor::SetSignificance(ESkateSignificance Significance)
+{
+	if (bScoredByManager)
+	{
+		// The boxes stay off for good once the manager does the scoring
+		return;
+	}
+
+	// Only the closest ring generates overlaps, dormant obstacles leave the scene query entirely
+	const bool bGenerateOverlaps = Significance == ESkateSignificance::Full;
+	const ECollisionEnabled::Type CollisionEnabled = Significance == ESkateSignificance::Dormant
+		? ECollisionEnabled::NoCollision
+		: ECollisionEnabled::QueryOnly;
+
+	for (UBoxComponent* Box : { MainCollision, FailCollision })
+	{
+		if (Box)
+		{
+			Box->SetGenerateOverlapEvents(bGenerateOverlaps);
+			Box->SetCollisionEnabled(CollisionEnabled);
+		}
+	}
+
+	if (Significance == ESkateSignificance::Dormant)
+	{
+		// Nothing can overlap a sleeping obstacle, so a pending flag reset is moot
+		GetWorldTimerManager().ClearTimer(ResetOverlapFlagsTimerHandle);
+		bHasCollided = false;
+		bFailZoneTriggered = false;
+	}
+}
+
+void AObstacleActor::ExportBakedObstacle(FBakedObstacle& OutObstacle) const
+{
+	const FTransform& ActorTransform = GetActorTransform();
+	OutObstacle.Location = FVector3f(ActorTransform.GetLocation());
+	OutObstacle.Rotation = FQuat4f(ActorTransform.GetRotation());
+	OutObstacle.Scale = FVector3f(ActorTransform.GetScale3D());
+
+	// Boxes are assumed to share the actor's orientation, only their offset and scaled size are kept
+	OutObstacle.MainCenter = FVector3f(MainCollision->GetComponentLocation());
+	OutObstacle.MainExtent = FVector3f(MainCollision->GetScaledBoxExtent());
+	OutObstacle.FailCenter = FVector3f(FailCollision->GetComponentLocation());
+	OutObstacle.FailExtent = FVector3f(FailCollision->GetScaledBoxExtent());
+
+	OutObstacle.PositivePoints = PositiveObstaclePointValue;
+	OutObstacle.NegativePoints = NegativeObstaclePointValue;
+	OutObstacle.ObstacleKey = ComputeObstacleKey();
+	OutObstacle.TypeId = ObstacleTypeId;
+}
+
+#if WITH_EDITOR
+bool AObstacleActor::SetBakedToTable(bool bBaked)
+{
+	if (bBakedToTable == bBaked)
+	{
+		return false;
+	}
+
+	Modify();
+	bBakedToTable = bBaked;
+	return true;
+}
+
+void AObstacleActor::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// The table record no longer matches, keep the actor in cooks until the level is rebaked
+	SetBakedToTable(false);
+}
+
+void AObstacleActor::PostEditMove(bool bFinished)
+{
+	Super::PostEditMove(bFinished);
+
+	if (bFinished)
+	{
+		SetBakedToTable(false);
+	}
+}
+#endif
+
+bool AObstacleActor::IsEditorOnly() const
+{
+#if WITH_EDITOR
+	if (bBakeToTable)
+	{
+		// Only strip the actor when the table can stand in for it, otherwise the obstacle would silently vanish from the cooked level
+		if (bBakedToTable)
+		{
+			return true;
+		}
+
+		// An error fails the cook, the obstacle still ships as an actor if the cook is forced through
+		UE_CLOG(!bReportedMissingBake && IsRunningCookCommandlet(), LogTemp, Error,
+			TEXT("%s is marked for baking but has not been baked since it was last edited, run BakeObstacleTable before cooking."), *GetPathName());
+		bReportedMissingBake = true;
+	}
+#endif
+
+	return Super::IsEditorOnly();
+}
+
+void AObstacleActor::HandOverScoringToManager()
+{
+	bScoredByManager = true;
+
+	// Only the scoring boxes go quiet, any blocking collision on the obstacle's meshes is left alone
+	for (UBoxComponent* Box : { MainCollision, FailCollision })
+	{
+		if (Box)
+		{
+			Box->SetGenerateOverlapEvents(false);
+			Box->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		}
+	}
+
+	GetWorldTimerManager().ClearTimer(ResetOverlapFlagsTimerHandle);
+
+	if (USkateSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<USkateSignificanceSubsystem>())
+	{
+		Significance->UnregisterObstacle(this);
+	}
+}
+
+bool AObstacleActor::HasOverlapListeners() const
+{
+	if (OnActorBeginOverlap.IsBound() || OnActorEndOverlap.IsBound()
+		|| GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AObstacleActor, ReceiveActorBeginOverlap))
+		|| GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AObstacleActor, ReceiveActorEndOverlap)))
+	{
+		return true;
+	}
+
+	// Component bound events ("On Component Begin Overlap (MainCollision)") are bound per class in the Blueprint hierarchy
+	for (const UClass* Class = GetClass(); Class; Class = Class->GetSuperClass())
+	{
+		const UComponentDelegateBinding* Binding = Cast<UComponentDelegateBinding>(
+			UBlueprintGeneratedClass::GetDynamicBindingObject(Class, UComponentDelegateBinding::StaticClass()));
+		if (!Binding)
+		{
+			continue;
+		}
+
+		for (const FBlueprintComponentDelegateBinding& Entry : Binding->ComponentDelegateBindings)
+		{
+			if (Entry.DelegatePropertyName == GET_MEMBER_NAME_CHECKED(UPrimitiveComponent, OnComponentBeginOverlap)
+				|| Entry.DelegatePropertyName == GET_MEMBER_NAME_CHECKED(UPrimitiveComponent, OnComponentEndOverlap))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void AObstacleActor::DeferToBakedTable()
+{
+	HandOverScoringToManager();
+
+	// The table's instanced meshes stand in for this actor from here on
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+}
@@ -7,6 +7,8 @@
 #include "ObstacleActor.generated.h"
 
 class UBoxComponent;
+enum class ESkateSignificance : uint8;
+struct FBakedObstacle;
 
 UCLASS()
 class SKATEBOARDSIM_API AObstacleActor : public AActor
@@ -18,9 +20,15 @@ public:
 	AObstacleActor();
 
 protected:
+	// Sets the obstacle key, before any actor's BeginPlay so the collision manager can match it against the baked table
+	virtual void PostInitializeComponents() override;
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the obstacle is removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Collision component for detecting overlaps
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
 	UBoxComponent* MainCollision;
@@ -57,8 +65,33 @@ protected:
 	int32 PositiveObstaclePointValue = 10;
 	int32 NegativeObstaclePointValue = 5;
 
+	// Extract this obstacle into the level's baked obstacle table and strip the actor from cooked builds
+	// (run BakeObstacleTable before cooking). Leave off for obstacles with custom logic that need to stay actors.
+	UPROPERTY(EditAnywhere, Category = "Baking")
+	bool bBakeToTable = false;
+
+	// Selects the instanced mesh the collision manager draws for a baked obstacle
+	UPROPERTY(EditAnywhere, Category = "Baking", meta = (EditCondition = "bBakeToTable"))
+	int32 ObstacleTypeId = 0;
+
+#if WITH_EDITORONLY_DATA
+	// Set by the bake once this obstacle's record is in the level's table and saved with the level, so the cook
+	// strips the actor without reading the table. Editing or duplicating the obstacle clears it until the next bake.
+	UPROPERTY(VisibleAnywhere, DuplicateTransient, TextExportTransient, Category = "Baking", AdvancedDisplay)
+	bool bBakedToTable = false;
+
+	// Keeps a missing bake to one cook error per obstacle
+	mutable bool bReportedMissingBake = false;
+#endif
+
+	// Set once the collision manager scores this obstacle instead of its overlap events
+	bool bScoredByManager = false;
+
 	FTimerHandle ResetOverlapFlagsTimerHandle;
 
+	// Stable id for this obstacle in the run history, derived from its path in the level
+	uint64 ObstacleKey;
+
 	class AObstacleCollisionManager* CollisionManager;
 
 public:	
@@ -70,5 +103,42 @@ public:
 
 	void SetCollisionManager(class AObstacleCollisionManager* Manager);
 
+	uint64 GetObstacleKey() const { return ObstacleKey; }
+
+	// 64-bit hash of the actor's full path without any PIE prefix, the baked table uses the same key
+	uint64 ComputeObstacleKey() const;
+
+	bool ShouldBakeToTable() const { return bBakeToTable; }
+
+	// Fills a flat table record from the registered components' world transforms
+	void ExportBakedObstacle(FBakedObstacle& OutObstacle) const;
+
+#if WITH_EDITOR
+	// Records whether the level's table now holds this obstacle, dirtying the level and returning true when it changes
+	bool SetBakedToTable(bool bBaked);
+
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PostEditMove(bool bFinished) override;
+#endif
+
+	// Baked obstacles live in the table at runtime, so cooking drops the actor itself once the bake has marked it.
+	// A flagged obstacle that was not baked stays an actor and logs a cook error.
+	virtual bool IsEditorOnly() const override;
+
+	// Turns off the scoring boxes once the collision manager evaluates this obstacle in its batched pass
+	void HandOverScoringToManager();
+
+	bool IsScoredByManager() const { return bScoredByManager; }
+
+	// Whether a Blueprint subclass or another object reacts to this obstacle's overlaps, which the batched pass would silence
+	bool HasOverlapListeners() const;
+
+	// Hands scoring and visuals over to the collision manager's baked table when the actor is still
+	// around at runtime (uncooked builds)
+	void DeferToBakedTable();
+
 	void ResetOverlapFlags();
+
+	// Scales collision work to how relevant this obstacle is to the local skater
+	void SetSignificance(ESkateSignificance Significance);
 };
@@ -2,41 +2,876 @@
 
 
 #include "ObstacleCollisionManager.h"
+#include "SkateboardSim.h"
 #include "ObstacleActor.h"
+#include "ObstacleTable.h"
+#include "SkateRunHistorySubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LocalPlayer.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "MassEntitySubsystem.h"
+#include "MassExecutor.h"
+#include "MassProcessingTypes.h"
+
+DECLARE_CYCLE_STAT(TEXT("Baked Table Load"), STAT_SkateBakedTableLoad, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Obstacle Scoring"), STAT_SkateObstacleScoring, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Obstacle Scoring Merge"), STAT_SkateObstacleScoringMerge, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Baked Obstacles"), STAT_SkateBakedObstacles, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Actor Obstacles"), STAT_SkateBatchedActorObstacles, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Skater Obstacle Pairs"), STAT_SkateObstaclePairs, STATGROUP_SkateboardSim);
+DECLARE_MEMORY_STAT(TEXT("Baked Obstacle Index"), STAT_SkateBakedIndexMemory, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Mass Obstacle Create"), STAT_SkateMassObstacleCreate, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Mass Obstacle Scoring"), STAT_SkateMassObstacleScoring, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Mass Obstacle Visuals"), STAT_SkateMassObstacleVisuals, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mass Obstacles"), STAT_SkateMassObstacles, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mass Visual Actors"), STAT_SkateMassVisualActors, STATGROUP_SkateboardSim);
+DECLARE_MEMORY_STAT(TEXT("Mass Obstacle Fragments"), STAT_SkateMassObstacleMemory, STATGROUP_SkateboardSim);
+
+// Batched actors give up their overlap boxes, so obstacles whose Blueprints listen for overlaps stay on their own events
+static TAutoConsoleVariable<bool> CVarBatchScoring(
+	TEXT("skate.Obstacles.BatchScoring"),
+	true,
+	TEXT("Score actor obstacles in the collision manager's batched pass instead of through their overlap events. ")
+	TEXT("Their scoring boxes are switched off; obstacles with Blueprint overlap events are left as they are. Read at level start."));
+
+static TAutoConsoleVariable<bool> CVarParallelScoring(
+	TEXT("skate.Obstacles.ParallelScoring"),
+	true,
+	TEXT("Spread obstacle overlap tests across worker threads. When false everything runs serially on the game thread."));
+
+static TAutoConsoleVariable<bool> CVarVerifyParallelScoring(
+	TEXT("skate.Obstacles.VerifyParallelScoring"),
+	false,
+	TEXT("Re-run every batched pass serially and check both produce identical score events. Debug only, expensive."));
+
+static TAutoConsoleVariable<bool> CVarMassEntities(
+	TEXT("skate.Obstacles.MassEntities"),
+	false,
+	TEXT("Run obstacles as MassEntity entities in every level, as if bUseMassEntities were set on the collision manager. Read at level start."));
+
+// Pairs per worker task, overlap tests are cheap so small batches would cost more in scheduling than they save
+static constexpr int32 OverlapTestBatchSize = 256;
+
+// Mass obstacles are sorted along a Morton curve over cells this size before creation, so chunks stay compact
+static constexpr float MassSortCellSize = 2000.0f;
+
+// Visual actors near the skater are re-evaluated this often, and at most this many spawn per evaluation
+static constexpr float MassVisualUpdateInterval = 0.25f;
+static constexpr int32 MaxMassVisualSpawnsPerUpdate = 16;
 
 // Sets default values
 AObstacleCollisionManager::AObstacleCollisionManager()
 {
+	// Actor obstacles score through overlap events; Tick only wakes up once obstacles are indexed or run as Mass entities
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
 	TotalScore = 0;
 
+	bRunActive = false;
+	RunStartTime = 0.0f;
+	RunCleared = 0;
+	RunFailed = 0;
 }
 
 // Called when the game starts or when spawned
 void AObstacleCollisionManager::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	const bool bMassObstacles = (bUseMassEntities || CVarMassEntities.GetValueOnGameThread()) && CreateMassObstacles();
+	if (!bMassObstacles)
+	{
+		LoadBakedObstacles();
+
+		if (CVarBatchScoring.GetValueOnGameThread())
+		{
+			for (TActorIterator<AObstacleActor> It(GetWorld()); It; ++It)
+			{
+				AddObstacleActor(*It);
+			}
+		}
+	}
+
+	StartRun();
+}
+
+void AObstacleCollisionManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FinishRun();
+
+	// On level teardown the visual actors go with everything else
+	DestroyMassObstacles(EndPlayReason == EEndPlayReason::Destroyed);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
 void AObstacleCollisionManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_SkateObstacleScoring);
+
+	const float Time = GetWorld()->GetTimeSeconds();
+
+	for (int32 SkaterIndex = Skaters.Num() - 1; SkaterIndex >= 0; --SkaterIndex)
+	{
+		if (!Skaters[SkaterIndex].Skater.IsValid())
+		{
+			Skaters.RemoveAt(SkaterIndex);
+		}
+	}
+
+	// Capsules are read here on the game thread, the passes below only see plain data
+	for (FSkaterEntry& Entry : Skaters)
+	{
+		const UCapsuleComponent* Capsule = Entry.Skater->GetCapsuleComponent();
+		Entry.Probe = { FVector3f(Capsule->GetComponentLocation()), Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight() };
+	}
+
+#if !UE_BUILD_SHIPPING
+	// Snapshot the state so the serial reference can replay the same frame afterwards
+	TArray<FSkaterObstacleState> VerifyStates;
+	const bool bVerify = CVarVerifyParallelScoring.GetValueOnGameThread();
+	if (bVerify)
+	{
+		for (const FSkaterEntry& Entry : Skaters)
+		{
+			VerifyStates.Add(Entry.State);
+		}
+	}
+#endif
+
+	EvaluateSkaters(Time);
+
+	if (MassObstacleEntities.Num() > 0)
+	{
+		EvaluateMassSkaters(DeltaTime, Time);
+		UpdateMassVisuals(DeltaTime);
+	}
+
+#if !UE_BUILD_SHIPPING
+	if (bVerify)
+	{
+		TArray<FObstacleScoreEvent> SerialEvents;
+		for (int32 SkaterIndex = 0; SkaterIndex < Skaters.Num(); ++SkaterIndex)
+		{
+			SerialEvents.Reset();
+			ScoringIndex.Evaluate(Skaters[SkaterIndex].Probe, VerifyStates[SkaterIndex], Time, SerialEvents);
+
+			const TArray<FObstacleScoreEvent>& BatchedEvents = Skaters[SkaterIndex].Events;
+			bool bMatches = SerialEvents.Num() == BatchedEvents.Num();
+			for (int32 EventIndex = 0; bMatches && EventIndex < SerialEvents.Num(); ++EventIndex)
+			{
+				const FObstacleScoreEvent& A = SerialEvents[EventIndex];
+				const FObstacleScoreEvent& B = BatchedEvents[EventIndex];
+				bMatches = A.ObstacleKey == B.ObstacleKey && A.Points == B.Points && A.bCleared == B.bCleared;
+			}
+			ensureMsgf(bMatches, TEXT("Batched obstacle scoring diverged from the serial path for skater %d."), SkaterIndex);
+		}
+	}
+#endif
+
+	// Merged in registration order, the same order a serial pass over the skaters produces
+	SCOPE_CYCLE_COUNTER(STAT_SkateObstacleScoringMerge);
+	for (const FSkaterEntry& Entry : Skaters)
+	{
+		ApplyScoreEvents(Entry.Events);
+
+		if (MassObstacleEntities.Num() > 0)
+		{
+			ApplyScoreEvents(Entry.MassEvents);
+		}
+	}
+}
+
+void AObstacleCollisionManager::EvaluateSkaters(float Time)
+{
+	const EParallelForFlags ParallelFlags = CVarParallelScoring.GetValueOnGameThread()
+		? EParallelForFlags::None
+		: EParallelForFlags::ForceSingleThread;
+
+	// Candidate lookups only read the index; each skater writes its own candidate list
+	ParallelFor(TEXT("SkateObstacles.Gather"), Skaters.Num(), 1, [this](int32 SkaterIndex)
+	{
+		FSkaterEntry& Entry = Skaters[SkaterIndex];
+		ScoringIndex.GatherCandidates(Entry.Probe, Entry.State.Candidates);
+	}, ParallelFlags);
+
+	// Flatten into skater x candidate pairs so a single busy skater still spreads across workers
+	PairTasks.Reset();
+	for (int32 SkaterIndex = 0; SkaterIndex < Skaters.Num(); ++SkaterIndex)
+	{
+		FSkaterEntry& Entry = Skaters[SkaterIndex];
+		Entry.FirstPair = PairTasks.Num();
+		for (const int32 ObstacleIndex : Entry.State.Candidates)
+		{
+			PairTasks.Add({ SkaterIndex, ObstacleIndex });
+		}
+	}
+	PairOverlaps.SetNumUninitialized(PairTasks.Num(), false);
+	SET_DWORD_STAT(STAT_SkateObstaclePairs, PairTasks.Num());
+
+	// Every pair owns its result slot, so the tests need no locks or atomics
+	ParallelFor(TEXT("SkateObstacles.Test"), PairTasks.Num(), OverlapTestBatchSize, [this](int32 PairIndex)
+	{
+		const FPairTask& Task = PairTasks[PairIndex];
+		PairOverlaps[PairIndex] = ScoringIndex.TestOverlaps(Skaters[Task.SkaterIndex].Probe, Task.ObstacleIndex);
+	}, ParallelFlags);
+
+	// Overlap state and events are per skater, each accumulator is only touched by its own task
+	ParallelFor(TEXT("SkateObstacles.Apply"), Skaters.Num(), 1, [this, Time](int32 SkaterIndex)
+	{
+		FSkaterEntry& Entry = Skaters[SkaterIndex];
+		const TConstArrayView<uint8> Overlaps(PairOverlaps.GetData() + Entry.FirstPair, Entry.State.Candidates.Num());
+
+		Entry.Events.Reset();
+		ScoringIndex.ApplyOverlaps(Entry.State, Entry.State.Candidates, Overlaps, Time, Entry.Events);
+	}, ParallelFlags);
 }
 
-void AObstacleCollisionManager::AddScore(int32 Points)
+void AObstacleCollisionManager::AddObstacleActor(AObstacleActor* Obstacle)
+{
+	if (!Obstacle || Obstacle->IsScoredByManager() || ActorObstacleIndices.Contains(Obstacle))
+	{
+		return;
+	}
+
+	// Switching the boxes off would silence the Blueprint's own overlap logic
+	if (Obstacle->HasOverlapListeners())
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("%s has overlap listeners, it keeps scoring through its own overlap events."), *Obstacle->GetName());
+		return;
+	}
+
+	FBakedObstacle Data;
+	Obstacle->ExportBakedObstacle(Data);
+	ActorObstacleIndices.Add(Obstacle, ScoringIndex.Add(Data));
+
+	Obstacle->SetCollisionManager(this);
+	Obstacle->HandOverScoringToManager();
+
+	SET_DWORD_STAT(STAT_SkateBatchedActorObstacles, ActorObstacleIndices.Num());
+	SetActorTickEnabled(true);
+}
+
+void AObstacleCollisionManager::RemoveObstacleActor(AObstacleActor* Obstacle)
+{
+	int32 Index;
+	if (ActorObstacleIndices.RemoveAndCopyValue(Obstacle, Index))
+	{
+		ScoringIndex.SetActive(Index, false);
+		SET_DWORD_STAT(STAT_SkateBatchedActorObstacles, ActorObstacleIndices.Num());
+	}
+}
+
+void AObstacleCollisionManager::RegisterSkater(ACharacter* Skater)
+{
+	// Same filter the obstacles' overlap handlers apply
+	if (Skater && !Skater->ActorHasTag(TEXT("Player")))
+	{
+		return;
+	}
+
+	if (Skater && !Skaters.ContainsByPredicate([Skater](const FSkaterEntry& Entry) { return Entry.Skater == Skater; }))
+	{
+		FSkaterEntry& Entry = Skaters.AddDefaulted_GetRef();
+		Entry.Skater = Skater;
+	}
+}
+
+void AObstacleCollisionManager::UnregisterSkater(ACharacter* Skater)
+{
+	for (int32 SkaterIndex = Skaters.Num() - 1; SkaterIndex >= 0; --SkaterIndex)
+	{
+		if (Skaters[SkaterIndex].Skater == Skater)
+		{
+			Skaters.RemoveAt(SkaterIndex);
+		}
+	}
+}
+
+bool AObstacleCollisionManager::IsOverlappingIndexedObstacle(const ACharacter* Skater) const
+{
+	if (!Skater || (ScoringIndex.Num() == 0 && MassObstacleEntities.Num() == 0))
+	{
+		return false;
+	}
+
+	const UCapsuleComponent* Capsule = Skater->GetCapsuleComponent();
+	const FSkaterProbe Probe = { FVector3f(Capsule->GetComponentLocation()), Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight() };
+
+	// Mass mode leaves the index empty, its obstacles only exist as entities
+	if (MassObstacleEntities.Num() > 0 && MassScoringProcessor)
+	{
+		UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+		if (EntitySubsystem && MassScoringProcessor->IsOverlappingAny(EntitySubsystem->GetMutableEntityManager(), Probe))
+		{
+			return true;
+		}
+	}
+
+	TArray<int32> Candidates;
+	ScoringIndex.GatherCandidates(Probe, Candidates);
+	for (const int32 Index : Candidates)
+	{
+		if (ScoringIndex.TestOverlaps(Probe, Index) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void AObstacleCollisionManager::ApplyScoreEvents(const TArray<FObstacleScoreEvent>& Events)
+{
+	for (const FObstacleScoreEvent& Event : Events)
+	{
+		if (Event.bCleared)
+		{
+			AddScore(Event.Points, Event.ObstacleKey);
+		}
+		else
+		{
+			SubtractScore(Event.Points, Event.ObstacleKey);
+		}
+	}
+}
+
+void AObstacleCollisionManager::LoadBakedObstacles()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateBakedTableLoad);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Baked actors only still exist in uncooked builds
+	TArray<AObstacleActor*> BakedActors;
+	for (TActorIterator<AObstacleActor> It(GetWorld()); It; ++It)
+	{
+		if (It->ShouldBakeToTable())
+		{
+			BakedActors.Add(*It);
+		}
+	}
+
+	const FString MapName = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+	FObstacleTable Table;
+	if (!Table.Load(FObstacleTable::GetTablePath(MapName)))
+	{
+		if (BakedActors.Num() > 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%d obstacles are marked for baking but %s has no obstacle table, run BakeObstacleTable. They stay actors for now."), BakedActors.Num(), *MapName);
+		}
+		return;
+	}
+
+	CreateObstacleInstances(Table.Obstacles, nullptr);
+
+	TSet<uint64> TableKeys;
+	TableKeys.Reserve(Table.Obstacles.Num());
+	for (const FBakedObstacle& Obstacle : Table.Obstacles)
+	{
+		TableKeys.Add(Obstacle.ObstacleKey);
+	}
+
+	const int32 NumObstacles = Table.Obstacles.Num();
+	ScoringIndex.Build(MoveTemp(Table.Obstacles));
+
+	// Only actors the table actually covers step aside, anything flagged since the last bake keeps scoring as an actor
+	int32 NumUnbaked = 0;
+	for (AObstacleActor* Obstacle : BakedActors)
+	{
+		if (TableKeys.Contains(Obstacle->GetObstacleKey()))
+		{
+			Obstacle->DeferToBakedTable();
+		}
+		else
+		{
+			++NumUnbaked;
+		}
+	}
+	UE_CLOG(NumUnbaked > 0, LogTemp, Warning, TEXT("%d obstacles are marked for baking but missing from the %s obstacle table, run BakeObstacleTable. They stay actors for now."), NumUnbaked, *MapName);
+
+	SetActorTickEnabled(ScoringIndex.Num() > 0);
+
+	SET_DWORD_STAT(STAT_SkateBakedObstacles, NumObstacles);
+	SET_MEMORY_STAT(STAT_SkateBakedIndexMemory, ScoringIndex.GetAllocatedSize());
+	UE_LOG(LogTemp, Log, TEXT("Loaded %d baked obstacles for %s (%.1f KB index) in %.2f ms."),
+		NumObstacles, *MapName, ScoringIndex.GetAllocatedSize() / 1024.0, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void AObstacleCollisionManager::CreateObstacleInstances(TConstArrayView<FBakedObstacle> Obstacles, TArray<int32>* OutInstanceIndices)
+{
+	TMap<int32, TArray<FTransform>> TransformsByType;
+	TMap<int32, TArray<int32>> ObstaclesByType;
+	for (int32 ObstacleIndex = 0; ObstacleIndex < Obstacles.Num(); ++ObstacleIndex)
+	{
+		const FBakedObstacle& Obstacle = Obstacles[ObstacleIndex];
+		TransformsByType.FindOrAdd(Obstacle.TypeId).Emplace(FQuat(Obstacle.Rotation), FVector(Obstacle.Location), FVector(Obstacle.Scale));
+		if (OutInstanceIndices)
+		{
+			ObstaclesByType.FindOrAdd(Obstacle.TypeId).Add(ObstacleIndex);
+		}
+	}
+
+	if (OutInstanceIndices)
+	{
+		OutInstanceIndices->Init(INDEX_NONE, Obstacles.Num());
+	}
+
+	if (!RootComponent)
+	{
+		USceneComponent* InstancesRoot = NewObject<USceneComponent>(this, TEXT("ObstacleInstancesRoot"));
+		SetRootComponent(InstancesRoot);
+		InstancesRoot->RegisterComponent();
+	}
+
+	// One instanced component per obstacle type instead of one actor per obstacle
+	for (TPair<int32, TArray<FTransform>>& Type : TransformsByType)
+	{
+		UStaticMesh* Mesh = ObstacleTypeMeshes.FindRef(Type.Key);
+		if (!Mesh)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("No mesh set for baked obstacle type %d, %d obstacles will be invisible."), Type.Key, Type.Value.Num());
+			continue;
+		}
+
+		UInstancedStaticMeshComponent*& Instances = InstancesByType.FindOrAdd(Type.Key);
+		if (!Instances)
+		{
+			// The instances replace the obstacle actors' meshes, so they block skaters with the mesh's own collision preset
+			Instances = NewObject<UInstancedStaticMeshComponent>(this);
+			Instances->bUseDefaultCollision = true;
+			Instances->SetStaticMesh(Mesh);
+			Instances->UpdateCollisionFromStaticMesh();
+			Instances->SetupAttachment(RootComponent);
+			Instances->RegisterComponent();
+			ObstacleInstances.Add(Instances);
+		}
+
+		const TArray<int32> NewInstances = Instances->AddInstances(Type.Value, /*bShouldReturnIndices*/ OutInstanceIndices != nullptr, /*bWorldSpace*/ true);
+		if (OutInstanceIndices)
+		{
+			const TArray<int32>& TypeObstacles = ObstaclesByType[Type.Key];
+			for (int32 Index = 0; Index < NewInstances.Num(); ++Index)
+			{
+				(*OutInstanceIndices)[TypeObstacles[Index]] = NewInstances[Index];
+			}
+		}
+	}
+}
+
+bool AObstacleCollisionManager::CreateMassObstacles()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateMassObstacleCreate);
+
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	if (!EntitySubsystem)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MassEntity is not available in this world, obstacles stay on the actor path."));
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FBakedObstacle> Obstacles;
+	TArray<TSubclassOf<AObstacleActor>> ActorClasses;
+
+	const FString MapName = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+	FObstacleTable Table;
+	const bool bHasTable = Table.Load(FObstacleTable::GetTablePath(MapName));
+	TSet<uint64> TableKeys;
+	if (bHasTable)
+	{
+		Obstacles = MoveTemp(Table.Obstacles);
+		TableKeys.Reserve(Obstacles.Num());
+		for (const FBakedObstacle& Obstacle : Obstacles)
+		{
+			ActorClasses.Add(ObstacleTypeActors.FindRef(Obstacle.TypeId));
+			TableKeys.Add(Obstacle.ObstacleKey);
+		}
+	}
+	const int32 NumFromTable = Obstacles.Num();
+
+	// Every obstacle actor goes; baked ones the table covers already have their record in it
+	TArray<AObstacleActor*> ConvertedActors;
+	for (TActorIterator<AObstacleActor> It(GetWorld()); It; ++It)
+	{
+		AObstacleActor* Obstacle = *It;
+		if (!Obstacle->ShouldBakeToTable() || !TableKeys.Contains(Obstacle->GetObstacleKey()))
+		{
+			Obstacle->ExportBakedObstacle(Obstacles.AddZeroed_GetRef());
+			ActorClasses.Add(Obstacle->GetClass());
+		}
+		ConvertedActors.Add(Obstacle);
+	}
+
+	if (Obstacles.Num() == 0)
+	{
+		return false;
+	}
+
+	// Morton order over coarse cells keeps each chunk's obstacles together, so its bounds are tight
+	TArray<TPair<uint32, int32>> Order;
+	Order.Reserve(Obstacles.Num());
+	for (int32 ObstacleIndex = 0; ObstacleIndex < Obstacles.Num(); ++ObstacleIndex)
+	{
+		const FVector3f& Center = Obstacles[ObstacleIndex].MainCenter;
+		const uint32 CellX = (uint32)FMath::Clamp(FMath::FloorToInt(Center.X / MassSortCellSize) + 32768, 0, 65535);
+		const uint32 CellY = (uint32)FMath::Clamp(FMath::FloorToInt(Center.Y / MassSortCellSize) + 32768, 0, 65535);
+		Order.Emplace(FMath::MortonCode2(CellX) | (FMath::MortonCode2(CellY) << 1), ObstacleIndex);
+	}
+	Order.Sort([](const TPair<uint32, int32>& A, const TPair<uint32, int32>& B)
+	{
+		return A.Key != B.Key ? A.Key < B.Key : A.Value < B.Value;
+	});
+
+	TArray<FBakedObstacle> SortedObstacles;
+	SortedObstacles.Reserve(Obstacles.Num());
+	for (const TPair<uint32, int32>& Entry : Order)
+	{
+		SortedObstacles.Add(Obstacles[Entry.Value]);
+	}
+
+	TArray<int32> InstanceIndices;
+	CreateObstacleInstances(SortedObstacles, &InstanceIndices);
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	const FMassArchetypeHandle Archetype = EntityManager.CreateArchetype({
+		FSkateObstacleTransformFragment::StaticStruct(),
+		FSkateObstacleBoxesFragment::StaticStruct(),
+		FSkateObstaclePointsFragment::StaticStruct(),
+		FSkateObstacleVisualFragment::StaticStruct(),
+		FSkateObstacleChunkFragment::StaticStruct() }, FName(TEXT("SkateObstacle")));
+
+	MassObstacleEntities.Reset();
+	EntityManager.BatchCreateEntities(Archetype, SortedObstacles.Num(), MassObstacleEntities);
+
+	for (int32 ObstacleIndex = 0; ObstacleIndex < SortedObstacles.Num(); ++ObstacleIndex)
+	{
+		const FBakedObstacle& Obstacle = SortedObstacles[ObstacleIndex];
+		const FMassEntityHandle Entity = MassObstacleEntities[ObstacleIndex];
+
+		FSkateObstacleTransformFragment& Transform = EntityManager.GetFragmentDataChecked<FSkateObstacleTransformFragment>(Entity);
+		Transform.Location = Obstacle.Location;
+		Transform.Rotation = Obstacle.Rotation;
+		Transform.Scale = Obstacle.Scale;
+
+		FSkateObstacleBoxesFragment& Boxes = EntityManager.GetFragmentDataChecked<FSkateObstacleBoxesFragment>(Entity);
+		Boxes.MainCenter = Obstacle.MainCenter;
+		Boxes.MainExtent = Obstacle.MainExtent;
+		Boxes.FailCenter = Obstacle.FailCenter;
+		Boxes.FailExtent = Obstacle.FailExtent;
+
+		FSkateObstaclePointsFragment& Points = EntityManager.GetFragmentDataChecked<FSkateObstaclePointsFragment>(Entity);
+		Points.PositivePoints = Obstacle.PositivePoints;
+		Points.NegativePoints = Obstacle.NegativePoints;
+		Points.ObstacleKey = Obstacle.ObstacleKey;
+		Points.ObstacleIndex = ObstacleIndex;
+
+		FSkateObstacleVisualFragment& Visual = EntityManager.GetFragmentDataChecked<FSkateObstacleVisualFragment>(Entity);
+		Visual.ActorClass = ActorClasses[Order[ObstacleIndex].Value];
+		Visual.TypeId = Obstacle.TypeId;
+		Visual.InstanceIndex = InstanceIndices[ObstacleIndex];
+
+		if (Visual.ActorClass)
+		{
+			MassVisualActorClasses.Add(Visual.ActorClass);
+		}
+	}
+
+	// Chunks that gained entities rebuild their bounds on the next pass
+	++USkateObstacleScoringProcessor::BoundsGeneration;
+
+	for (AObstacleActor* Obstacle : ConvertedActors)
+	{
+		Obstacle->Destroy();
+	}
+
+	MassScoringProcessor = NewObject<USkateObstacleScoringProcessor>(this);
+	MassScoringProcessor->Initialize(*this);
+	MassScoringProcessor->Frame = &MassScoringFrame;
+
+	MassVisualProcessor = NewObject<USkateObstacleVisualLODProcessor>(this);
+	MassVisualProcessor->Initialize(*this);
+	MassVisualProcessor->Frame = &MassVisualFrame;
+	MassVisualFrame.SpawnRadius = MassVisualActorRadius;
+	MassVisualFrame.DespawnRadius = MassVisualActorRadius * 1.25f;
+	MassVisualUpdateCountdown = 0.0f;
+
+	SetActorTickEnabled(true);
+
+	// Chunk fragments and the archetype's own bookkeeping come on top, but are shared by hundreds of entities
+	const int32 FragmentBytesPerObstacle = sizeof(FSkateObstacleTransformFragment) + sizeof(FSkateObstacleBoxesFragment)
+		+ sizeof(FSkateObstaclePointsFragment) + sizeof(FSkateObstacleVisualFragment)
+		+ sizeof(FMassEntityHandle);
+
+	SET_DWORD_STAT(STAT_SkateMassObstacles, MassObstacleEntities.Num());
+	SET_MEMORY_STAT(STAT_SkateMassObstacleMemory, (int64)MassObstacleEntities.Num() * FragmentBytesPerObstacle);
+	UE_LOG(LogTemp, Log, TEXT("Created %d Mass obstacles for %s (%d from the baked table, %d converted actors), %d fragment bytes each, in %.2f ms."),
+		MassObstacleEntities.Num(), *MapName, NumFromTable, MassObstacleEntities.Num() - NumFromTable, FragmentBytesPerObstacle,
+		(FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	return true;
+}
+
+void AObstacleCollisionManager::DestroyMassObstacles(bool bDestroyVisualActors)
+{
+	if (MassObstacleEntities.Num() == 0)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	if (UMassEntitySubsystem* EntitySubsystem = World ? World->GetSubsystem<UMassEntitySubsystem>() : nullptr)
+	{
+		FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+
+		if (bDestroyVisualActors)
+		{
+			for (const FMassEntityHandle Entity : MassObstacleEntities)
+			{
+				if (EntityManager.IsEntityValid(Entity))
+				{
+					if (AObstacleActor* Actor = EntityManager.GetFragmentDataChecked<FSkateObstacleVisualFragment>(Entity).Actor.Get())
+					{
+						Actor->Destroy();
+					}
+				}
+			}
+		}
+
+		EntityManager.BatchDestroyEntities(MassObstacleEntities);
+	}
+
+	MassObstacleEntities.Reset();
+	NumMassVisualActors = 0;
+	SET_DWORD_STAT(STAT_SkateMassObstacles, 0);
+	SET_DWORD_STAT(STAT_SkateMassVisualActors, 0);
+	SET_MEMORY_STAT(STAT_SkateMassObstacleMemory, 0);
+}
+
+void AObstacleCollisionManager::EvaluateMassSkaters(float DeltaTime, float Time)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateMassObstacleScoring);
+
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	if (!EntitySubsystem || !MassScoringProcessor)
+	{
+		return;
+	}
+
+	// Overlap state lives with each skater, so it leaves with the skater and there is no cap on how many are scored
+	MassScoringFrame.Skaters.Reset();
+	for (FSkaterEntry& Entry : Skaters)
+	{
+		MassScoringFrame.Skaters.Add({ Entry.Probe, &Entry.MassState, &Entry.MassEvents });
+	}
+	MassScoringFrame.Time = Time;
+
+	FMassProcessingContext ProcessingContext(EntitySubsystem->GetMutableEntityManager(), DeltaTime);
+	UE::Mass::Executor::Run(*MassScoringProcessor, ProcessingContext);
+
+	// The frame points into the skater entries, which may move once skaters come and go
+	MassScoringFrame.Skaters.Reset();
+}
+
+void AObstacleCollisionManager::UpdateMassVisuals(float DeltaTime)
+{
+	MassVisualUpdateCountdown -= DeltaTime;
+	if (MassVisualUpdateCountdown > 0.0f)
+	{
+		return;
+	}
+	MassVisualUpdateCountdown = MassVisualUpdateInterval;
+
+	SCOPE_CYCLE_COUNTER(STAT_SkateMassObstacleVisuals);
+
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APawn* ViewPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (!EntitySubsystem || !MassVisualProcessor || !ViewPawn)
+	{
+		return;
+	}
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+
+	MassVisualFrame.ViewLocation = FVector3f(ViewPawn->GetActorLocation());
+	FMassProcessingContext ProcessingContext(EntityManager, DeltaTime);
+	UE::Mass::Executor::Run(*MassVisualProcessor, ProcessingContext);
+
+	TSet<UInstancedStaticMeshComponent*> DirtyInstances;
+
+	for (const FMassEntityHandle Entity : MassVisualFrame.ToDespawn)
+	{
+		FSkateObstacleVisualFragment& Visual = EntityManager.GetFragmentDataChecked<FSkateObstacleVisualFragment>(Entity);
+		if (AObstacleActor* Actor = Visual.Actor.Get())
+		{
+			Actor->Destroy();
+			--NumMassVisualActors;
+		}
+		Visual.Actor = nullptr;
+
+		// The instance takes over again
+		UInstancedStaticMeshComponent* Instances = InstancesByType.FindRef(Visual.TypeId);
+		if (Instances && Visual.InstanceIndex != INDEX_NONE)
+		{
+			const FSkateObstacleTransformFragment& Transform = EntityManager.GetFragmentDataChecked<FSkateObstacleTransformFragment>(Entity);
+			Instances->UpdateInstanceTransform(Visual.InstanceIndex, FTransform(FQuat(Transform.Rotation), FVector(Transform.Location), FVector(Transform.Scale)),
+				/*bWorldSpace*/ true, /*bMarkRenderStateDirty*/ false, /*bTeleport*/ true);
+			DirtyInstances.Add(Instances);
+		}
+	}
+
+	// Spawning is the expensive part, the rest are picked up by the next evaluation
+	const int32 NumToSpawn = FMath::Min(MassVisualFrame.ToSpawn.Num(), MaxMassVisualSpawnsPerUpdate);
+	for (int32 SpawnIndex = 0; SpawnIndex < NumToSpawn; ++SpawnIndex)
+	{
+		const FMassEntityHandle Entity = MassVisualFrame.ToSpawn[SpawnIndex];
+		FSkateObstacleVisualFragment& Visual = EntityManager.GetFragmentDataChecked<FSkateObstacleVisualFragment>(Entity);
+		const FSkateObstacleTransformFragment& Transform = EntityManager.GetFragmentDataChecked<FSkateObstacleTransformFragment>(Entity);
+		const FTransform ActorTransform(FQuat(Transform.Rotation), FVector(Transform.Location), FVector(Transform.Scale));
+
+		AObstacleActor* Actor = GetWorld()->SpawnActorDeferred<AObstacleActor>(Visual.ActorClass, ActorTransform, this, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		if (!Actor)
+		{
+			continue;
+		}
+
+		// Visuals only, the entity keeps doing the scoring
+		Actor->HandOverScoringToManager();
+		Actor->FinishSpawning(ActorTransform);
+		Visual.Actor = Actor;
+		++NumMassVisualActors;
+
+		// Collapse the instance so it does not draw inside the actor
+		UInstancedStaticMeshComponent* Instances = InstancesByType.FindRef(Visual.TypeId);
+		if (Instances && Visual.InstanceIndex != INDEX_NONE)
+		{
+			Instances->UpdateInstanceTransform(Visual.InstanceIndex, FTransform(FQuat::Identity, ActorTransform.GetLocation(), FVector::ZeroVector),
+				/*bWorldSpace*/ true, /*bMarkRenderStateDirty*/ false, /*bTeleport*/ true);
+			DirtyInstances.Add(Instances);
+		}
+	}
+
+	for (UInstancedStaticMeshComponent* Instances : DirtyInstances)
+	{
+		Instances->MarkRenderStateDirty();
+	}
+
+	SET_DWORD_STAT(STAT_SkateMassVisualActors, NumMassVisualActors);
+}
+
+#if WITH_EDITOR
+void AObstacleCollisionManager::BakeObstacleTable()
+{
+	FObstacleTable Table;
+	const FString Filename = FObstacleTable::GetTablePath(GetOutermost()->GetName());
+	if (!Table.BuildFromLevel(GetLevel()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Obstacle table %s was not written, its obstacles need unique keys."), *Filename);
+	}
+	else if (Table.Save(Filename))
+	{
+		UE_LOG(LogTemp, Log, TEXT("Baked %d obstacles to %s."), Table.Obstacles.Num(), *Filename);
+
+		// Marks the obstacles for stripping, saving the level keeps the flags for the cook
+		UE_CLOG(Table.MarkBakedObstacles(GetLevel()), LogTemp, Warning, TEXT("Save the level so the cook picks up the baked obstacles."));
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write obstacle table %s."), *Filename);
+	}
+}
+#endif
+
+void AObstacleCollisionManager::AddScore(int32 Points, uint64 ObstacleKey)
 {
 	TotalScore += Points;
 	OnScoreUpdated.Broadcast(TotalScore);
+
+	if (bRunActive && ObstacleKey != 0)
+	{
+		RunEvents.Add({ ObstacleKey, GetWorld()->GetTimeSeconds() - RunStartTime, Points, true });
+		++RunCleared;
+	}
 }
 
-void AObstacleCollisionManager::SubtractScore(int32 Points)
+void AObstacleCollisionManager::SubtractScore(int32 Points, uint64 ObstacleKey)
 {
+	const int32 AppliedPoints = TotalScore != 0 ? Points : 0;
+
 	if (TotalScore != 0)
 	{
 		TotalScore -= Points;
 		OnScoreUpdated.Broadcast(TotalScore);
 	}
+
+	// A fail still counts as an attempt on the obstacle even when there was no score to take
+	if (bRunActive && ObstacleKey != 0)
+	{
+		RunEvents.Add({ ObstacleKey, GetWorld()->GetTimeSeconds() - RunStartTime, -AppliedPoints, false });
+		++RunFailed;
+	}
+}
+
+void AObstacleCollisionManager::StartRun()
+{
+	if (TotalScore != 0)
+	{
+		TotalScore = 0;
+		OnScoreUpdated.Broadcast(TotalScore);
+	}
+
+	bRunActive = true;
+	RunStartTime = GetWorld()->GetTimeSeconds();
+	RunCleared = 0;
+	RunFailed = 0;
+	RunEvents.Reset();
+}
+
+void AObstacleCollisionManager::FinishRun()
+{
+	if (!bRunActive)
+	{
+		return;
+	}
+	bRunActive = false;
+
+	// Nothing happened, not worth a history entry
+	if (RunEvents.Num() == 0 && TotalScore == 0)
+	{
+		return;
+	}
+
+	USkateRunHistorySubsystem* RunHistory = GEngine ? GEngine->GetEngineSubsystem<USkateRunHistorySubsystem>() : nullptr;
+	UGameInstance* GameInstance = GetGameInstance();
+	if (!RunHistory || !GameInstance)
+	{
+		return;
+	}
+
+	FSkateRunSummary Summary;
+	const ULocalPlayer* LocalPlayer = GameInstance->GetFirstGamePlayer();
+	Summary.PlayerName = LocalPlayer ? LocalPlayer->GetNickname() : FString();
+	if (Summary.PlayerName.IsEmpty())
+	{
+		Summary.PlayerName = TEXT("Player");
+	}
+	Summary.FinalScore = TotalScore;
+	Summary.DurationSeconds = GetWorld()->GetTimeSeconds() - RunStartTime;
+	Summary.NumCleared = RunCleared;
+	Summary.NumFailed = RunFailed;
+
+	RunHistory->SubmitRun(MoveTemp(Summary), MoveTemp(RunEvents));
+	RunEvents.Reset();
 }
 
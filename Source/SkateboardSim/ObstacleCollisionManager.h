@@ -4,8 +4,16 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "SkateRunHistoryStore.h"
+#include "ObstacleScoringIndex.h"
+#include "SkateMassObstacles.h"
 #include "ObstacleCollisionManager.generated.h"
 
+class ACharacter;
+class AObstacleActor;
+class UStaticMesh;
+class UInstancedStaticMeshComponent;
+
 UCLASS()
 class SKATEBOARDSIM_API AObstacleCollisionManager : public AActor
 {
@@ -19,12 +27,37 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the level ends, submits the run in progress
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
-	// Called every frame
+	// Called every frame while any obstacles are indexed, scores them against the registered skaters
 	virtual void Tick(float DeltaTime) override;
 
-	void AddScore(int32 Points);
-	void SubtractScore(int32 Points);
+	// Skaters that batched obstacles are scored against, only characters tagged "Player" are accepted
+	void RegisterSkater(ACharacter* Skater);
+	void UnregisterSkater(ACharacter* Skater);
+
+	// Whether the skater's capsule is inside a baked, batched or Mass obstacle's boxes, which have no collision to overlap
+	bool IsOverlappingIndexedObstacle(const ACharacter* Skater) const;
+
+	// Moves an actor obstacle's clear/fail evaluation from its overlap events into the batched pass.
+	// Obstacles in the level are added at BeginPlay, spawned ones can be added later. Obstacles with Blueprint
+	// overlap events are left on those events.
+	void AddObstacleActor(AObstacleActor* Obstacle);
+	void RemoveObstacleActor(AObstacleActor* Obstacle);
+
+	// ObstacleKey identifies the obstacle in the run history, 0 for score that does not come from one
+	void AddScore(int32 Points, uint64 ObstacleKey = 0);
+	void SubtractScore(int32 Points, uint64 ObstacleKey = 0);
+
+	/** Resets the score and starts recording a new run */
+	UFUNCTION(BlueprintCallable, Category = "Score")
+	void StartRun();
+
+	/** Ends the current run and hands it to the local run history */
+	UFUNCTION(BlueprintCallable, Category = "Score")
+	void FinishRun();
 
 	UFUNCTION(BlueprintCallable, Category = "Score")
 	int32 GetCurrentScore() const { return TotalScore; }
@@ -32,7 +65,102 @@ public:
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnScoreUpdated, int32, NewScore);
 	FOnScoreUpdated OnScoreUpdated;
 
+	// Meshes drawn as instances for baked obstacles, keyed by their ObstacleTypeId
+	UPROPERTY(EditAnywhere, Category = "Obstacles")
+	TMap<int32, TObjectPtr<UStaticMesh>> ObstacleTypeMeshes;
+
+	// Run the level's obstacles as MassEntity entities scored by processors instead of as actors or
+	// the batched index. Obstacle actors are converted and destroyed at level start, and only come back
+	// as visual-only actors near the local skater. The skate.Obstacles.MassEntities cvar forces it on.
+	UPROPERTY(EditAnywhere, Category = "Obstacles|Mass")
+	bool bUseMassEntities = false;
+
+	// Actor spawned near the skater for a baked obstacle type in Mass mode, converted actors respawn as their own class
+	UPROPERTY(EditAnywhere, Category = "Obstacles|Mass")
+	TMap<int32, TSubclassOf<AObstacleActor>> ObstacleTypeActors;
+
+	// Mass obstacles closer than this to the local skater get a visual actor, dropped again at 1.25x the distance
+	UPROPERTY(EditAnywhere, Category = "Obstacles|Mass")
+	float MassVisualActorRadius = 3000.0f;
+
+#if WITH_EDITOR
+	// Writes this level's baked obstacle table and flags its obstacles as baked, save the level afterwards
+	// (the BakeObstacleTable commandlet does both before cooking)
+	UFUNCTION(CallInEditor, Category = "Obstacles")
+	void BakeObstacleTable();
+#endif
+
 private:
+	// Loads the level's baked obstacle table into the scoring index and spawns its instanced visuals
+	void LoadBakedObstacles();
+
+	// Runs the skater x candidate obstacle pass, leaving each skater's events in its entry
+	void EvaluateSkaters(float Time);
+
+	void ApplyScoreEvents(const TArray<FObstacleScoreEvent>& Events);
+
+	// Mass mode: converts the baked table and every obstacle actor into entities, in spatial order
+	bool CreateMassObstacles();
+	void DestroyMassObstacles(bool bDestroyVisualActors);
+	void EvaluateMassSkaters(float DeltaTime, float Time);
+	void UpdateMassVisuals(float DeltaTime);
+
+	// Adds one instance per obstacle to its type's instanced mesh, OutInstanceIndices gets INDEX_NONE for types without a mesh
+	void CreateObstacleInstances(TConstArrayView<FBakedObstacle> Obstacles, TArray<int32>* OutInstanceIndices);
+
+	struct FSkaterEntry
+	{
+		TWeakObjectPtr<ACharacter> Skater;
+		FSkaterObstacleState State;
+		FSkaterProbe Probe;
+		int32 FirstPair = 0;
+		TArray<FObstacleScoreEvent> Events;		// This frame's results, merged on the game thread
+
+		// Mass mode keeps the skater's pairs against obstacle entities apart from the index's
+		FSkaterObstacleState MassState;
+		TArray<FObstacleScoreEvent> MassEvents;
+	};
+
+	struct FPairTask
+	{
+		int32 SkaterIndex;
+		int32 ObstacleIndex;
+	};
+
+	TArray<FSkaterEntry> Skaters;
+	FObstacleScoringIndex ScoringIndex;
+	TMap<AObstacleActor*, int32> ActorObstacleIndices;
+
+	// Scratch for the batched pass, reused every frame
+	TArray<FPairTask> PairTasks;
+	TArray<uint8> PairOverlaps;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInstancedStaticMeshComponent>> ObstacleInstances;
+	TMap<int32, UInstancedStaticMeshComponent*> InstancesByType;
+
+	UPROPERTY(Transient)
+	TObjectPtr<USkateObstacleScoringProcessor> MassScoringProcessor;
+	UPROPERTY(Transient)
+	TObjectPtr<USkateObstacleVisualLODProcessor> MassVisualProcessor;
+
+	// Keeps converted actors' classes loaded for respawning once the placed actors are gone
+	UPROPERTY(Transient)
+	TSet<TSubclassOf<AObstacleActor>> MassVisualActorClasses;
+
+	TArray<FMassEntityHandle> MassObstacleEntities;
+	FSkateMassScoringFrame MassScoringFrame;
+	FSkateMassVisualFrame MassVisualFrame;
+	float MassVisualUpdateCountdown = 0.0f;
+	int32 NumMassVisualActors = 0;
+
 	int32 TotalScore;
 
+	/** Run being recorded for the history */
+	bool bRunActive;
+	float RunStartTime;
+	int32 RunCleared;
+	int32 RunFailed;
+	TArray<FSkateObstacleEvent> RunEvents;
+
 };
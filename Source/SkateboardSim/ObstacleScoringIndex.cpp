@@ -0,0 +1,286 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleScoringIndex.h"
+#include "Algo/Unique.h"
+
+namespace ObstacleScoringIndex
+{
+	enum EOverlapBits : uint8
+	{
+		MainBit = 1 << 0,
+		FailBit = 1 << 1
+	};
+
+	/** Slab test of a segment against an origin-centred box */
+	static bool SegmentIntersectsBox(const FVector3f& Start, const FVector3f& End, const FVector3f& Extent)
+	{
+		const FVector3f Direction = End - Start;
+		float MinT = 0.0f;
+		float MaxT = 1.0f;
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (FMath::IsNearlyZero(Direction[Axis]))
+			{
+				if (FMath::Abs(Start[Axis]) > Extent[Axis])
+				{
+					return false;
+				}
+				continue;
+			}
+
+			const float InvDirection = 1.0f / Direction[Axis];
+			float T0 = (-Extent[Axis] - Start[Axis]) * InvDirection;
+			float T1 = (Extent[Axis] - Start[Axis]) * InvDirection;
+			if (T0 > T1)
+			{
+				Swap(T0, T1);
+			}
+
+			MinT = FMath::Max(MinT, T0);
+			MaxT = FMath::Min(MaxT, T1);
+			if (MinT > MaxT)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Capsule against oriented box, done as the capsule's core segment against the box grown by the radius.
+	 * Square corners make it slightly generous there, which is fine for scoring volumes.
+	 */
+	static bool CapsuleOverlapsBox(const FSkaterProbe& Probe, const FVector3f& Center, const FVector3f& Extent, const FQuat4f& Rotation)
+	{
+		const FVector3f LocalCenter = Rotation.UnrotateVector(Probe.Location - Center);
+		const FVector3f LocalAxis = Rotation.UnrotateVector(FVector3f::UpVector) * FMath::Max(Probe.HalfHeight - Probe.Radius, 0.0f);
+
+		return SegmentIntersectsBox(LocalCenter - LocalAxis, LocalCenter + LocalAxis, Extent + FVector3f(Probe.Radius));
+	}
+}
+
+void FObstacleScoringIndex::Reset()
+{
+	Obstacles.Reset();
+	ActiveObstacles.Reset();
+	Cells.Reset();
+}
+
+FIntPoint FObstacleScoringIndex::GetCell(float X, float Y) const
+{
+	return FIntPoint(FMath::FloorToInt(X / CellSize), FMath::FloorToInt(Y / CellSize));
+}
+
+void FObstacleScoringIndex::Build(TArray<FBakedObstacle>&& InObstacles)
+{
+	Reset();
+
+	TArray<FBakedObstacle> NewObstacles = MoveTemp(InObstacles);
+	Obstacles.Reserve(NewObstacles.Num());
+	for (const FBakedObstacle& Obstacle : NewObstacles)
+	{
+		Add(Obstacle);
+	}
+}
+
+int32 FObstacleScoringIndex::Add(const FBakedObstacle& Obstacle)
+{
+	const int32 Index = Obstacles.Add(Obstacle);
+	ActiveObstacles.Add(true);
+
+	FVector2f FootprintMin, FootprintMax;
+	GetFootprint(Obstacle.MainCenter, Obstacle.MainExtent, Obstacle.FailCenter, Obstacle.FailExtent, FootprintMin, FootprintMax);
+	const FIntPoint MinCell = GetCell(FootprintMin.X, FootprintMin.Y);
+	const FIntPoint MaxCell = GetCell(FootprintMax.X, FootprintMax.Y);
+
+	for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+	{
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+		{
+			Cells.FindOrAdd(FIntPoint(CellX, CellY)).Add(Index);
+		}
+	}
+
+	return Index;
+}
+
+void FObstacleScoringIndex::SetActive(int32 Index, bool bActive)
+{
+	if (ActiveObstacles.IsValidIndex(Index))
+	{
+		ActiveObstacles[Index] = bActive;
+	}
+}
+
+void FObstacleScoringIndex::GatherCandidates(const FSkaterProbe& Probe, TArray<int32>& OutCandidates) const
+{
+	OutCandidates.Reset();
+
+	const FIntPoint MinCell = GetCell(Probe.Location.X - Probe.Radius, Probe.Location.Y - Probe.Radius);
+	const FIntPoint MaxCell = GetCell(Probe.Location.X + Probe.Radius, Probe.Location.Y + Probe.Radius);
+
+	for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+	{
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+		{
+			if (const TArray<int32>* Cell = Cells.Find(FIntPoint(CellX, CellY)))
+			{
+				for (const int32 Index : *Cell)
+				{
+					if (ActiveObstacles[Index])
+					{
+						OutCandidates.Add(Index);
+					}
+				}
+			}
+		}
+	}
+
+	// Obstacles straddling cells show up more than once, and evaluation order has to be stable
+	OutCandidates.Sort();
+	OutCandidates.SetNum(Algo::Unique(OutCandidates), false);
+}
+
+uint8 FObstacleScoringIndex::TestOverlaps(const FSkaterProbe& Probe, int32 Index) const
+{
+	const FBakedObstacle& Obstacle = Obstacles[Index];
+	return TestBoxes(Probe, Obstacle.MainCenter, Obstacle.MainExtent, Obstacle.FailCenter, Obstacle.FailExtent, Obstacle.Rotation);
+}
+
+void FObstacleScoringIndex::GetFootprint(const FVector3f& MainCenter, const FVector3f& MainExtent, const FVector3f& FailCenter, const FVector3f& FailExtent,
+	FVector2f& OutMin, FVector2f& OutMax)
+{
+	const float MainReach = FVector2f(MainExtent.X, MainExtent.Y).Size();
+	const float FailReach = FVector2f(FailExtent.X, FailExtent.Y).Size();
+	OutMin = FVector2f::Min(FVector2f(MainCenter.X, MainCenter.Y) - FVector2f(MainReach), FVector2f(FailCenter.X, FailCenter.Y) - FVector2f(FailReach));
+	OutMax = FVector2f::Max(FVector2f(MainCenter.X, MainCenter.Y) + FVector2f(MainReach), FVector2f(FailCenter.X, FailCenter.Y) + FVector2f(FailReach));
+}
+
+uint8 FObstacleScoringIndex::TestBoxes(const FSkaterProbe& Probe, const FVector3f& MainCenter, const FVector3f& MainExtent,
+	const FVector3f& FailCenter, const FVector3f& FailExtent, const FQuat4f& Rotation)
+{
+	using namespace ObstacleScoringIndex;
+
+	const bool bInMain = CapsuleOverlapsBox(Probe, MainCenter, MainExtent, Rotation);
+	const bool bInFail = CapsuleOverlapsBox(Probe, FailCenter, FailExtent, Rotation);
+
+	return (bInMain ? MainBit : 0) | (bInFail ? FailBit : 0);
+}
+
+void FObstacleScoringIndex::StepPair(FObstaclePairState& Pair, uint8 OverlapBits, float Time, bool& bOutFailed, bool& bOutCleared)
+{
+	using namespace ObstacleScoringIndex;
+
+	bOutFailed = false;
+	bOutCleared = false;
+
+	if (Pair.ResetTime >= 0.0f && Time >= Pair.ResetTime)
+	{
+		Pair.bFailTriggered = false;
+		Pair.ResetTime = -1.0f;
+	}
+
+	// Fail first, so landing in both boxes in the same step is not also counted as a clear
+	if ((OverlapBits & FailBit) && !(Pair.OverlapBits & FailBit))
+	{
+		Pair.bFailTriggered = true;
+		bOutFailed = true;
+	}
+
+	if ((OverlapBits & MainBit) && !(Pair.OverlapBits & MainBit))
+	{
+		bOutCleared = !Pair.bFailTriggered;
+		Pair.ResetTime = Time + FlagResetDelay;
+	}
+
+	Pair.OverlapBits = OverlapBits;
+}
+
+void FObstacleScoringIndex::Evaluate(const FSkaterProbe& Probe, FSkaterObstacleState& State, float Time, TArray<FObstacleScoreEvent>& OutEvents) const
+{
+	GatherCandidates(Probe, State.Candidates);
+
+	TArray<uint8, TInlineAllocator<64>> Overlaps;
+	Overlaps.SetNumUninitialized(State.Candidates.Num());
+	for (int32 CandidateIndex = 0; CandidateIndex < State.Candidates.Num(); ++CandidateIndex)
+	{
+		Overlaps[CandidateIndex] = TestOverlaps(Probe, State.Candidates[CandidateIndex]);
+	}
+
+	ApplyOverlaps(State, State.Candidates, Overlaps, Time, OutEvents);
+}
+
+void FObstacleScoringIndex::ApplyOverlaps(FSkaterObstacleState& State, TConstArrayView<int32> Candidates, TConstArrayView<uint8> Overlaps, float Time, TArray<FObstacleScoreEvent>& OutEvents) const
+{
+	check(Candidates.Num() == Overlaps.Num());
+
+	const uint32 Stamp = ++State.Stamp;
+
+	for (int32 CandidateIndex = 0; CandidateIndex < Candidates.Num(); ++CandidateIndex)
+	{
+		const int32 Index = Candidates[CandidateIndex];
+		const uint8 OverlapBits = Overlaps[CandidateIndex];
+		const FBakedObstacle& Obstacle = Obstacles[Index];
+
+		FSkaterObstacleState::FPairState* Pair = State.Pairs.Find(Index);
+		if (!Pair)
+		{
+			if (OverlapBits == 0)
+			{
+				continue;
+			}
+			Pair = &State.Pairs.Add(Index);
+		}
+
+		Pair->Stamp = Stamp;
+
+		bool bFailed;
+		bool bCleared;
+		StepPair(*Pair, OverlapBits, Time, bFailed, bCleared);
+
+		if (bFailed)
+		{
+			OutEvents.Add({ Obstacle.ObstacleKey, Obstacle.NegativePoints, false });
+		}
+		if (bCleared)
+		{
+			OutEvents.Add({ Obstacle.ObstacleKey, Obstacle.PositivePoints, true });
+		}
+	}
+
+	RetireUnvisitedPairs(State, Time);
+}
+
+void FObstacleScoringIndex::RetireUnvisitedPairs(FSkaterObstacleState& State, float Time)
+{
+	// Anything not visited this step has been left behind; keep it until its flag reset is due. A fail with no
+	// reset scheduled yet stays too, the actor path keeps that flag until the main box is next entered.
+	for (auto It = State.Pairs.CreateIterator(); It; ++It)
+	{
+		FSkaterObstacleState::FPairState& Pair = It.Value();
+		if (Pair.Stamp == State.Stamp)
+		{
+			continue;
+		}
+
+		Pair.OverlapBits = 0;
+		const bool bResetDue = Pair.ResetTime >= 0.0f ? Time >= Pair.ResetTime : !Pair.bFailTriggered;
+		if (bResetDue)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+size_t FObstacleScoringIndex::GetAllocatedSize() const
+{
+	size_t Size = Obstacles.GetAllocatedSize() + ActiveObstacles.GetAllocatedSize() + Cells.GetAllocatedSize();
+	for (const TPair<FIntPoint, TArray<int32>>& Cell : Cells)
+	{
+		Size += Cell.Value.GetAllocatedSize();
+	}
+	return Size;
+}
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ObstacleTable.h"
+
+/** A skater's capsule for one evaluation pass */
+struct FSkaterProbe
+{
+	FVector3f Location;
+	float Radius;
+	float HalfHeight;
+};
+
+/** One obstacle cleared or failed by a skater */
+struct FObstacleScoreEvent
+{
+	uint64 ObstacleKey;
+	int32 Points;		// Positive for a clear, the penalty for a fail
+	bool bCleared;
+};
+
+/** Begin-overlap tracking for one skater against one obstacle */
+struct FObstaclePairState
+{
+	uint8 OverlapBits = 0;
+	bool bFailTriggered = false;
+	float ResetTime = -1.0f;
+};
+
+/** Begin-overlap tracking for one skater against the indexed obstacles */
+struct FSkaterObstacleState
+{
+	struct FPairState : FObstaclePairState
+	{
+		uint32 Stamp = 0;
+	};
+
+	TMap<int32, FPairState> Pairs;
+	uint32 Stamp = 0;
+
+	/** Scratch space reused between evaluations so they do not allocate */
+	TArray<int32> Candidates;
+};
+
+/**
+ * Data-only obstacles in a uniform grid, scored against skater capsules without
+ * any actors or physics overlaps. Mirrors AObstacleActor's clear/fail rules.
+ */
+class SKATEBOARDSIM_API FObstacleScoringIndex
+{
+public:
+	/** Matches AObstacleActor's delay before its fail flag resets after a main box overlap */
+	static constexpr float FlagResetDelay = 0.1f;
+
+	void Reset();
+
+	/** Takes ownership of the obstacles and rebuilds the grid */
+	void Build(TArray<FBakedObstacle>&& InObstacles);
+
+	/** Adds one obstacle to the grid, returns its index */
+	int32 Add(const FBakedObstacle& Obstacle);
+
+	/** Inactive obstacles stay in place (indices are stable) but are never returned as candidates */
+	void SetActive(int32 Index, bool bActive);
+
+	int32 Num() const { return Obstacles.Num(); }
+	const TArray<FBakedObstacle>& GetObstacles() const { return Obstacles; }
+
+	/** Advances one skater's overlap state to Time and appends any clears or fails in obstacle order */
+	void Evaluate(const FSkaterProbe& Probe, FSkaterObstacleState& State, float Time, TArray<FObstacleScoreEvent>& OutEvents) const;
+
+	/**
+	 * The three steps of Evaluate, split so the overlap tests can run as one flat batch over
+	 * every skater and candidate pair. Only ApplyOverlaps touches skater state.
+	 */
+	void GatherCandidates(const FSkaterProbe& Probe, TArray<int32>& OutCandidates) const;
+	uint8 TestOverlaps(const FSkaterProbe& Probe, int32 Index) const;
+	void ApplyOverlaps(FSkaterObstacleState& State, TConstArrayView<int32> Candidates, TConstArrayView<uint8> Overlaps, float Time, TArray<FObstacleScoreEvent>& OutEvents) const;
+
+	size_t GetAllocatedSize() const;
+
+	/** Overlap bits of a capsule against an obstacle's main and fail boxes, for callers that store obstacles their own way */
+	static uint8 TestBoxes(const FSkaterProbe& Probe, const FVector3f& MainCenter, const FVector3f& MainExtent,
+		const FVector3f& FailCenter, const FVector3f& FailExtent, const FQuat4f& Rotation);
+
+	/** XY bounds covering both boxes under any rotation, the fail box is not required to lie inside the main box */
+	static void GetFootprint(const FVector3f& MainCenter, const FVector3f& MainExtent, const FVector3f& FailCenter, const FVector3f& FailExtent,
+		FVector2f& OutMin, FVector2f& OutMax);
+
+	/** Advances one pair to Time with this step's overlap bits, reporting a fail and/or a clear */
+	static void StepPair(FObstaclePairState& Pair, uint8 OverlapBits, float Time, bool& bOutFailed, bool& bOutCleared);
+
+	/** Ends the overlap of every pair not stamped with State.Stamp this step, and drops those with nothing left to track */
+	static void RetireUnvisitedPairs(FSkaterObstacleState& State, float Time);
+
+private:
+	FIntPoint GetCell(float X, float Y) const;
+
+	TArray<FBakedObstacle> Obstacles;
+	TBitArray<> ActiveObstacles;
+	TMap<FIntPoint, TArray<int32>> Cells;
+	float CellSize = 1000.0f;
+};
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleTable.h"
+#include "ObstacleActor.h"
+#include "Engine/Level.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogObstacleTable, Log, All);
+
+namespace ObstacleTable
+{
+	static constexpr uint32 Magic = 0x544F4B53;	// 'SKOT'
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 RecordSize;	// Catches layout changes that forgot to bump the version
+		int32 Count;
+		uint32 Crc;
+	};
+}
+
+FString FObstacleTable::GetTablePath(const FString& MapName)
+{
+	return FPaths::ProjectContentDir() / TEXT("ObstacleTables") / (FPackageName::GetShortName(MapName) + TEXT(".obt"));
+}
+
+bool FObstacleTable::Load(const FString& Filename)
+{
+	Obstacles.Reset();
+
+	TUniquePtr<IFileHandle> Handle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!Handle)
+	{
+		return false;
+	}
+
+	ObstacleTable::FHeader Header;
+	if (!Handle->Read(reinterpret_cast<uint8*>(&Header), sizeof(Header)))
+	{
+		return false;
+	}
+
+	const int64 DataSize = (int64)Header.Count * sizeof(FBakedObstacle);
+	if (Header.Magic != ObstacleTable::Magic || Header.Version != Version || Header.RecordSize != sizeof(FBakedObstacle)
+		|| Header.Count < 0 || Handle->Size() != (int64)sizeof(Header) + DataSize)
+	{
+		UE_LOG(LogObstacleTable, Warning, TEXT("Obstacle table '%s' is stale or corrupt, rebake the level."), *Filename);
+		return false;
+	}
+
+	// One read straight into the final array, no per-obstacle construction
+	Obstacles.SetNumUninitialized(Header.Count);
+	if (!Handle->Read(reinterpret_cast<uint8*>(Obstacles.GetData()), DataSize)
+		|| FCrc::MemCrc32(Obstacles.GetData(), DataSize) != Header.Crc)
+	{
+		UE_LOG(LogObstacleTable, Warning, TEXT("Obstacle table '%s' failed its checksum, rebake the level."), *Filename);
+		Obstacles.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FObstacleTable::Save(const FString& Filename) const
+{
+	const int64 DataSize = (int64)Obstacles.Num() * sizeof(FBakedObstacle);
+
+	ObstacleTable::FHeader Header;
+	Header.Magic = ObstacleTable::Magic;
+	Header.Version = Version;
+	Header.RecordSize = sizeof(FBakedObstacle);
+	Header.Count = Obstacles.Num();
+	Header.Crc = FCrc::MemCrc32(Obstacles.GetData(), DataSize);
+
+	TArray<uint8> Bytes;
+	Bytes.Reserve(sizeof(Header) + DataSize);
+	Bytes.Append(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	Bytes.Append(reinterpret_cast<const uint8*>(Obstacles.GetData()), DataSize);
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FObstacleTable::BuildFromLevel(const ULevel* Level)
+{
+	Obstacles.Reset();
+
+	if (!Level)
+	{
+		return true;
+	}
+
+	// Two obstacles sharing a key would also share their run history and be matched to each other's records
+	TMap<uint64, const AObstacleActor*> ObstaclesByKey;
+	bool bUniqueKeys = true;
+
+	for (const AActor* Actor : Level->Actors)
+	{
+		const AObstacleActor* Obstacle = Cast<AObstacleActor>(Actor);
+		if (Obstacle && Obstacle->ShouldBakeToTable())
+		{
+			FBakedObstacle& Baked = Obstacles.AddZeroed_GetRef();
+			Obstacle->ExportBakedObstacle(Baked);
+
+			if (const AObstacleActor** Existing = ObstaclesByKey.Find(Baked.ObstacleKey))
+			{
+				UE_LOG(LogObstacleTable, Error, TEXT("%s and %s have the same obstacle key %llu, rename one of them."),
+					*(*Existing)->GetPathName(), *Obstacle->GetPathName(), Baked.ObstacleKey);
+				bUniqueKeys = false;
+			}
+			else
+			{
+				ObstaclesByKey.Add(Baked.ObstacleKey, Obstacle);
+			}
+		}
+	}
+
+	// Actor order in a level shifts as it is edited, sorting keeps rebakes byte-identical
+	Obstacles.Sort([](const FBakedObstacle& A, const FBakedObstacle& B) { return A.ObstacleKey < B.ObstacleKey; });
+
+	return bUniqueKeys;
+}
+
+#if WITH_EDITOR
+bool FObstacleTable::MarkBakedObstacles(ULevel* Level) const
+{
+	if (!Level)
+	{
+		return false;
+	}
+
+	TSet<uint64> TableKeys;
+	TableKeys.Reserve(Obstacles.Num());
+	for (const FBakedObstacle& Obstacle : Obstacles)
+	{
+		TableKeys.Add(Obstacle.ObstacleKey);
+	}
+
+	bool bChanged = false;
+	for (AActor* Actor : Level->Actors)
+	{
+		if (AObstacleActor* Obstacle = Cast<AObstacleActor>(Actor))
+		{
+			const bool bBaked = Obstacle->ShouldBakeToTable() && TableKeys.Contains(Obstacle->ComputeObstacleKey());
+			bChanged |= Obstacle->SetBakedToTable(bBaked);
+		}
+	}
+	return bChanged;
+}
+#endif
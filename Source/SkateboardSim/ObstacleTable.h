@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ULevel;
+
+/**
+ * Flat record for one baked obstacle. Kept trivially copyable so a whole table
+ * is read from disk straight into an array with no per-entry work.
+ */
+struct FBakedObstacle
+{
+	// Actor transform, used to place the obstacle's visuals
+	FVector3f Location;
+	FQuat4f Rotation;
+	FVector3f Scale;
+
+	// World space box centres and scaled half extents, oriented by Rotation
+	FVector3f MainCenter;
+	FVector3f MainExtent;
+	FVector3f FailCenter;
+	FVector3f FailExtent;
+
+	int32 PositivePoints;
+	int32 NegativePoints;
+	uint64 ObstacleKey;
+	int32 TypeId;
+};
+
+/** Versioned on-disk table of every baked obstacle in one level */
+struct SKATEBOARDSIM_API FObstacleTable
+{
+	/** Bump whenever FBakedObstacle changes layout, stale tables are then rejected */
+	static constexpr uint32 Version = 2;
+
+	TArray<FBakedObstacle> Obstacles;
+
+	/** Where the table for a map lives, e.g. Content/ObstacleTables/TestingParkLevel.obt */
+	static FString GetTablePath(const FString& MapName);
+
+	/** Loads a table with a single read into Obstacles */
+	bool Load(const FString& Filename);
+
+	bool Save(const FString& Filename) const;
+
+	/** Collects every obstacle in the level flagged for baking; components must be registered. Fails on duplicate keys. */
+	bool BuildFromLevel(const ULevel* Level);
+
+#if WITH_EDITOR
+	/** Flags each obstacle in the level with whether this saved table holds it, the cook strips only flagged ones. Returns whether any flag changed. */
+	bool MarkBakedObstacles(ULevel* Level) const;
+#endif
+};
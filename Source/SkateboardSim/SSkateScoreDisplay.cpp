@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SSkateScoreDisplay.h"
+#include "SkateboardSim.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Fonts/FontMeasure.h"
+#include "Rendering/DrawElements.h"
+#include "Rendering/SlateRenderer.h"
+#include "Styling/CoreStyle.h"
+
+DECLARE_CYCLE_STAT(TEXT("Score HUD Paint"), STAT_SkateScoreHUDPaint, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Score HUD Flush"), STAT_SkateScoreHUDFlush, STATGROUP_SkateboardSim);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Score HUD Events"), STAT_SkateScoreHUDEvents, STATGROUP_SkateboardSim);
+
+namespace SkateScoreDisplay
+{
+	static const TCHAR* ScoreLabel = TEXT("Score: ");
+	static const TCHAR* ComboLabel = TEXT("  x");
+	static const TCHAR* LossSeparator = TEXT("  ");
+
+	// Enough for the label, a sign and any int32 so the buffers never regrow
+	static constexpr int32 NumberCapacity = 32;
+}
+
+void SSkateScoreDisplay::Construct(const FArguments& InArgs)
+{
+	Font = InArgs._Font.HasValidFont() ? InArgs._Font : FCoreStyle::GetDefaultFontStyle("Bold", 32);
+	ScoreColor = InArgs._ScoreColor;
+	GainColor = InArgs._GainColor;
+	LossColor = InArgs._LossColor;
+	TrickColor = InArgs._TrickColor;
+
+	ScoreText.Reserve(SkateScoreDisplay::NumberCapacity);
+	GainText.Reserve(SkateScoreDisplay::NumberCapacity);
+	LossText.Reserve(SkateScoreDisplay::NumberCapacity);
+	TrickText.Reserve(64);
+	PendingTrickName.Reserve(64);
+
+	ScoreText.Append(SkateScoreDisplay::ScoreLabel);
+	ScoreText.AppendInt(Score);
+	MeasureLines();
+}
+
+void SSkateScoreDisplay::SetScore(int32 InScore)
+{
+	Score = PendingScore = InScore;
+	LastGain = PendingGain = 0;
+	LastLoss = PendingLoss = 0;
+	ComboCount = PendingCombo = 0;
+
+	ScoreText.Reset();
+	ScoreText.Append(SkateScoreDisplay::ScoreLabel);
+	ScoreText.AppendInt(Score);
+	GainText.Reset();
+	LossText.Reset();
+
+	MeasureLines();
+	Invalidate(EInvalidateWidgetReason::Layout);
+}
+
+void SSkateScoreDisplay::QueueScore(int32 NewScore)
+{
+	INC_DWORD_STAT(STAT_SkateScoreHUDEvents);
+
+	const int32 Delta = NewScore - PendingScore;
+	PendingScore = NewScore;
+
+	// Kept apart so a gain and a loss in one frame do not net out into a misleading single number
+	if (Delta > 0)
+	{
+		PendingGain += Delta;
+	}
+	else
+	{
+		PendingLoss += Delta;
+	}
+
+	// Combo is decided per event so batching several of them does not lose a broken streak
+	PendingCombo = Delta > 0 ? PendingCombo + 1 : 0;
+
+	QueueFlush();
+}
+
+void SSkateScoreDisplay::QueueTrickName(const FString& TrickName)
+{
+	PendingTrickName = TrickName;
+	bTrickNamePending = true;
+
+	QueueFlush();
+}
+
+void SSkateScoreDisplay::SetFont(const FSlateFontInfo& InFont)
+{
+	if (InFont.HasValidFont() && InFont != Font)
+	{
+		Font = InFont;
+		MeasureLines();
+		Invalidate(EInvalidateWidgetReason::Layout);
+	}
+}
+
+void SSkateScoreDisplay::SetColors(const FLinearColor& InScoreColor, const FLinearColor& InGainColor, const FLinearColor& InLossColor, const FLinearColor& InTrickColor)
+{
+	ScoreColor = InScoreColor;
+	GainColor = InGainColor;
+	LossColor = InLossColor;
+	TrickColor = InTrickColor;
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+void SSkateScoreDisplay::QueueFlush()
+{
+	if (!bFlushQueued)
+	{
+		bFlushQueued = true;
+
+		// A zero period timer fires on the next Slate tick, folding this frame's events together
+		RegisterActiveTimer(0.0f, FWidgetActiveTimerDelegate::CreateSP(this, &SSkateScoreDisplay::FlushPending));
+	}
+}
+
+EActiveTimerReturnType SSkateScoreDisplay::FlushPending(double InCurrentTime, float InDeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateScoreHUDFlush);
+
+	bFlushQueued = false;
+
+	bool bChanged = false;
+
+	if (PendingScore != Score || PendingGain != 0 || PendingLoss != 0)
+	{
+		Score = PendingScore;
+		LastGain = PendingGain;
+		LastLoss = PendingLoss;
+		ComboCount = PendingCombo;
+		PendingGain = 0;
+		PendingLoss = 0;
+
+		// Reset keeps the reserved capacity, so rebuilding the strings stays allocation free
+		ScoreText.Reset();
+		ScoreText.Append(SkateScoreDisplay::ScoreLabel);
+		ScoreText.AppendInt(Score);
+
+		GainText.Reset();
+		if (LastGain > 0)
+		{
+			GainText.AppendChar(TEXT('+'));
+			GainText.AppendInt(LastGain);
+			if (ComboCount > 1)
+			{
+				GainText.Append(SkateScoreDisplay::ComboLabel);
+				GainText.AppendInt(ComboCount);
+			}
+		}
+
+		LossText.Reset();
+		if (LastLoss < 0)
+		{
+			if (!GainText.IsEmpty())
+			{
+				LossText.Append(SkateScoreDisplay::LossSeparator);
+			}
+			LossText.AppendInt(LastLoss);
+		}
+
+		bChanged = true;
+	}
+
+	if (bTrickNamePending)
+	{
+		bTrickNamePending = false;
+		if (!TrickText.Equals(PendingTrickName, ESearchCase::CaseSensitive))
+		{
+			TrickText.Reset();
+			TrickText.Append(PendingTrickName);
+			bChanged = true;
+		}
+	}
+
+	if (bChanged)
+	{
+		// Proportional fonts change width even at the same length, so the measured size decides
+		Invalidate(MeasureLines() ? EInvalidateWidgetReason::Layout : EInvalidateWidgetReason::Paint);
+	}
+
+	return EActiveTimerReturnType::Stop;
+}
+
+bool SSkateScoreDisplay::MeasureLines()
+{
+	if (!FSlateApplication::IsInitialized())
+	{
+		return false;
+	}
+
+	const TSharedRef<FSlateFontMeasure> FontMeasure = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
+
+	const FVector2D OldSize = ComputeDesiredSize(1.0f);
+
+	LineHeight = FontMeasure->GetMaxCharacterHeight(Font);
+	ScoreWidth = FontMeasure->Measure(ScoreText, Font).X;
+	GainWidth = FontMeasure->Measure(GainText, Font).X;
+	LossWidth = FontMeasure->Measure(LossText, Font).X;
+	TrickWidth = FontMeasure->Measure(TrickText, Font).X;
+
+	return ComputeDesiredSize(1.0f) != OldSize;
+}
+
+FVector2D SSkateScoreDisplay::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	const float Width = FMath::Max3(ScoreWidth, GainWidth + LossWidth, TrickWidth);
+	return FVector2D(Width, LineHeight * 3.0f);
+}
+
+int32 SSkateScoreDisplay::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateScoreHUDPaint);
+
+	const FVector2f LineSize(AllottedGeometry.GetLocalSize().X, LineHeight);
+	const ESlateDrawEffect DrawEffects = ShouldBeEnabled(bParentEnabled) ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
+	const FLinearColor Tint = InWidgetStyle.GetColorAndOpacityTint();
+
+	FSlateDrawElement::MakeText(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(LineSize, FSlateLayoutTransform(FVector2f(0.0f, 0.0f))),
+		ScoreText, Font, DrawEffects, ScoreColor * Tint);
+
+	if (!GainText.IsEmpty())
+	{
+		FSlateDrawElement::MakeText(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(LineSize, FSlateLayoutTransform(FVector2f(0.0f, LineHeight))),
+			GainText, Font, DrawEffects, GainColor * Tint);
+	}
+
+	if (!LossText.IsEmpty())
+	{
+		FSlateDrawElement::MakeText(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(LineSize, FSlateLayoutTransform(FVector2f(GainWidth, LineHeight))),
+			LossText, Font, DrawEffects, LossColor * Tint);
+	}
+
+	if (!TrickText.IsEmpty())
+	{
+		FSlateDrawElement::MakeText(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(LineSize, FSlateLayoutTransform(FVector2f(0.0f, LineHeight * 2.0f))),
+			TrickText, Font, DrawEffects, TrickColor * Tint);
+	}
+
+	return LayerId;
+}
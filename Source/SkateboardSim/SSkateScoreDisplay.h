@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SLeafWidget.h"
+#include "Fonts/SlateFontInfo.h"
+
+/**
+ * Retained score and trick readout. Text is formatted into preallocated buffers and painted
+ * directly, and every score event in a frame is folded into a single invalidation.
+ */
+class SKATEBOARDSIM_API SSkateScoreDisplay : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SSkateScoreDisplay)
+		: _Font()
+		, _ScoreColor(FLinearColor::White)
+		, _GainColor(FLinearColor::Green)
+		, _LossColor(FLinearColor::Red)
+		, _TrickColor(FLinearColor::Yellow)
+	{}
+		SLATE_ARGUMENT(FSlateFontInfo, Font)
+		SLATE_ARGUMENT(FLinearColor, ScoreColor)
+		SLATE_ARGUMENT(FLinearColor, GainColor)
+		SLATE_ARGUMENT(FLinearColor, LossColor)
+		SLATE_ARGUMENT(FLinearColor, TrickColor)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+	/** Snaps the readout to a total without showing it as a gain (e.g. when first bound) */
+	void SetScore(int32 InScore);
+
+	/** Queues a new total; several calls in one frame are applied in one pass */
+	void QueueScore(int32 NewScore);
+
+	/** Queues the name of the last trick landed */
+	void QueueTrickName(const FString& TrickName);
+
+	void SetFont(const FSlateFontInfo& InFont);
+	void SetColors(const FLinearColor& InScoreColor, const FLinearColor& InGainColor, const FLinearColor& InLossColor, const FLinearColor& InTrickColor);
+
+	// SWidget interface
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+
+protected:
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+
+private:
+	/** Applies everything queued since the last frame, runs once per frame at most */
+	EActiveTimerReturnType FlushPending(double InCurrentTime, float InDeltaTime);
+
+	void QueueFlush();
+
+	/** Measures every line into the cached widths, returns true if the desired size changed */
+	bool MeasureLines();
+
+	FSlateFontInfo Font;
+	FLinearColor ScoreColor;
+	FLinearColor GainColor;
+	FLinearColor LossColor;
+	FLinearColor TrickColor;
+
+	/** Displayed values, gains and losses from one frame are shown side by side rather than netted */
+	int32 Score = 0;
+	int32 LastGain = 0;
+	int32 LastLoss = 0;
+	int32 ComboCount = 0;
+
+	/** Values received since the last flush */
+	int32 PendingScore = 0;
+	int32 PendingGain = 0;
+	int32 PendingLoss = 0;
+	int32 PendingCombo = 0;
+	FString PendingTrickName;
+	bool bTrickNamePending = false;
+	bool bFlushQueued = false;
+
+	/** Formatted lines, reused between updates so formatting does not allocate */
+	FString ScoreText;
+	FString GainText;
+	FString LossText;
+	FString TrickText;
+
+	/** Measured when the text changes, so neither layout nor painting has to measure */
+	float LineHeight = 0.0f;
+	float ScoreWidth = 0.0f;
+	float GainWidth = 0.0f;
+	float LossWidth = 0.0f;
+	float TrickWidth = 0.0f;
+};
@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SkateCameraComponent.h"
+#include "SkateboardSim.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Camera Update"), STAT_SkateCameraUpdate, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Probes Sync"), STAT_SkateCameraProbesSync, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Probes Async"), STAT_SkateCameraProbesAsync, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Probes Reused"), STAT_SkateCameraProbesReused, STATGROUP_SkateboardSim);
+
+namespace SkateCamera
+{
+	static const FHitResult* FindBlockingHit(const TArray<FHitResult>& Hits)
+	{
+		return Hits.FindByPredicate([](const FHitResult& Result) { return Result.bBlockingHit; });
+	}
+}
+
+static TAutoConsoleVariable<bool> CVarCameraBudgetedProbe(
+	TEXT("skate.Camera.BudgetedProbe"),
+	true,
+	TEXT("When false the skate camera probes synchronously every frame, like a stock spring arm."));
+
+static TAutoConsoleVariable<bool> CVarCameraSpeedAdaptive(
+	TEXT("skate.Camera.SpeedAdaptive"),
+	true,
+	TEXT("When false arm length, FOV and lag stay at their slow-speed values."));
+
+USkateCameraComponent::USkateCameraComponent()
+{
+	SlowSpeed = 500.0f;
+	FastSpeed = 1050.0f;
+	SlowArmLength = 400.0f;
+	FastArmLength = 520.0f;
+	SlowFieldOfView = 90.0f;
+	FastFieldOfView = 105.0f;
+	SlowLagSpeed = 12.0f;
+	FastLagSpeed = 7.0f;
+	AirArmLengthBonus = 80.0f;
+	AirBlendTime = 0.4f;
+	ResponseSpeed = 3.0f;
+
+	ClearProbeInterval = 4;
+	ProbeReuseDistance = 40.0f;
+	bAsyncProbe = true;
+	ProbeRecoverySpeed = 6.0f;
+
+	TargetArmLength = SlowArmLength;
+	bEnableCameraLag = true;
+	CameraLagSpeed = SlowLagSpeed;
+}
+
+void USkateCameraComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	DesiredArmLength = TargetArmLength;
+	ProbedArmLength = TargetArmLength;
+	ProbeHitFraction = 1.0f;
+	bProbeObstructed = false;
+	bHasClearVolume = false;
+	PendingProbe = FTraceHandle();
+	PendingClearanceProbe = FTraceHandle();
+	FramesSinceProbe = ClearProbeInterval;
+}
+
+void USkateCameraComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateCameraUpdate);
+
+	UpdateSpeedTargets(DeltaTime);
+
+	// The base tick drives UpdateDesiredArmLocation, where the probe result is applied
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
+
+void USkateCameraComponent::UpdateSpeedTargets(float DeltaTime)
+{
+	if (!FollowCamera.IsValid())
+	{
+		for (USceneComponent* Child : GetAttachChildren())
+		{
+			if (UCameraComponent* Camera = Cast<UCameraComponent>(Child))
+			{
+				FollowCamera = Camera;
+				break;
+			}
+		}
+	}
+
+	float SpeedAlpha = 0.0f;
+	float AirAlpha = 0.0f;
+
+	if (CVarCameraSpeedAdaptive.GetValueOnGameThread())
+	{
+		if (const AActor* Owner = GetOwner())
+		{
+			SpeedAlpha = FMath::GetRangePct(SlowSpeed, FastSpeed, Owner->GetVelocity().Size2D());
+			SpeedAlpha = FMath::Clamp(SpeedAlpha, 0.0f, 1.0f);
+		}
+
+		const ACharacter* Character = Cast<ACharacter>(GetOwner());
+		const bool bFalling = Character && Character->GetCharacterMovement() && Character->GetCharacterMovement()->IsFalling();
+
+		// Grows while airborne and drains at the same rate after landing, so the arm eases back in
+		AirTime = FMath::Clamp(AirTime + (bFalling ? DeltaTime : -DeltaTime), 0.0f, AirBlendTime);
+		AirAlpha = AirBlendTime > 0.0f ? AirTime / AirBlendTime : (bFalling ? 1.0f : 0.0f);
+	}
+
+	const float TargetLength = FMath::Lerp(SlowArmLength, FastArmLength, SpeedAlpha) + AirArmLengthBonus * AirAlpha;
+	const float TargetLag = FMath::Lerp(SlowLagSpeed, FastLagSpeed, SpeedAlpha);
+	const float TargetFieldOfView = FMath::Lerp(SlowFieldOfView, FastFieldOfView, SpeedAlpha);
+
+	DesiredArmLength = FMath::FInterpTo(DesiredArmLength, TargetLength, DeltaTime, ResponseSpeed);
+	CameraLagSpeed = FMath::FInterpTo(CameraLagSpeed, TargetLag, DeltaTime, ResponseSpeed);
+
+	if (UCameraComponent* Camera = FollowCamera.Get())
+	{
+		const float FieldOfView = FMath::FInterpTo(Camera->FieldOfView, TargetFieldOfView, DeltaTime, ResponseSpeed);
+		if (!FMath::IsNearlyEqual(FieldOfView, Camera->FieldOfView, 0.01f))
+		{
+			Camera->SetFieldOfView(FieldOfView);
+		}
+	}
+}
+
+void USkateCameraComponent::UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime)
+{
+	if (bDoTrace)
+	{
+		// Probe the full desired arm, not the clipped one, so the result says how far it may extend again.
+		// Lag is ignored here; it only ever pulls the camera back towards the origin.
+		const FRotator DesiredRot = GetTargetRotation();
+		const FVector ArmOrigin = GetComponentLocation() + TargetOffset;
+		const FVector ArmEnd = ArmOrigin - DesiredRot.Vector() * DesiredArmLength + FRotationMatrix(DesiredRot).TransformVector(SocketOffset);
+		UpdateProbe(ArmOrigin, ArmEnd);
+
+		// Snap in on a hit so the camera never sits inside geometry, ease out once it clears
+		const float ProbeLength = DesiredArmLength * ProbeHitFraction;
+		ProbedArmLength = ProbeLength < ProbedArmLength
+			? ProbeLength
+			: FMath::FInterpTo(ProbedArmLength, ProbeLength, DeltaTime, ProbeRecoverySpeed);
+	}
+	else
+	{
+		ProbedArmLength = DesiredArmLength;
+	}
+
+	// The spring arm itself never traces; its length already carries the probe result
+	TargetArmLength = FMath::Min(DesiredArmLength, ProbedArmLength);
+	Super::UpdateDesiredArmLocation(false, bDoLocationLag, bDoRotationLag, DeltaTime);
+}
+
+void USkateCameraComponent::UpdateProbe(const FVector& ArmOrigin, const FVector& ArmEnd)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	++FramesSinceProbe;
+
+	if (PendingProbe.IsValid())
+	{
+		FTraceDatum Datum;
+		if (World->QueryTraceData(PendingProbe, Datum))
+		{
+			ApplyProbeResult(SkateCamera::FindBlockingHit(Datum.OutHits));
+
+			// Issued in the same frame, so it has finished too; a lost result only costs the reuse
+			FTraceDatum ClearanceDatum;
+			bHasClearVolume = !bProbeObstructed && PendingClearanceProbe.IsValid()
+				&& World->QueryTraceData(PendingClearanceProbe, ClearanceDatum)
+				&& !SkateCamera::FindBlockingHit(ClearanceDatum.OutHits);
+
+			PendingProbe = FTraceHandle();
+			PendingClearanceProbe = FTraceHandle();
+		}
+		else if (World->IsTraceHandleValid(PendingProbe, false))
+		{
+			// Still in flight, its result lands next frame
+			return;
+		}
+		else
+		{
+			// Expired before it was read (e.g. a hitch skipped a frame), issue a fresh one
+			PendingProbe = FTraceHandle();
+			PendingClearanceProbe = FTraceHandle();
+		}
+	}
+
+	const bool bBudgeted = CVarCameraBudgetedProbe.GetValueOnGameThread();
+
+	// The widened sweep covers every arm whose ends are within ProbeReuseDistance of the probed one (the volume is convex),
+	// so the camera's own sweep along it would be clear too. It is still re-checked every few frames in case something moved into it.
+	if (bBudgeted && bHasClearVolume && FramesSinceProbe < ClearProbeInterval
+		&& FMath::PointDistToSegment(ArmOrigin, LastProbeOrigin, LastProbeEnd) <= ProbeReuseDistance
+		&& FMath::PointDistToSegment(ArmEnd, LastProbeOrigin, LastProbeEnd) <= ProbeReuseDistance)
+	{
+		INC_DWORD_STAT(STAT_SkateCameraProbesReused);
+		return;
+	}
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SkateCameraProbe), false, GetOwner());
+	const FCollisionShape Shape = FCollisionShape::MakeSphere(ProbeSize);
+	const FCollisionShape ClearanceShape = FCollisionShape::MakeSphere(ProbeSize + ProbeReuseDistance);
+
+	// Only a clear view is worth widening, next to geometry the wider sweep would hit and never be reused
+	const bool bProbeClearance = bBudgeted && !bProbeObstructed && ProbeReuseDistance > 0.0f;
+
+	LastProbeOrigin = ArmOrigin;
+	LastProbeEnd = ArmEnd;
+	FramesSinceProbe = 0;
+	bHasClearVolume = false;
+
+	if (bBudgeted && bAsyncProbe)
+	{
+		INC_DWORD_STAT(STAT_SkateCameraProbesAsync);
+		PendingProbe = World->AsyncSweepByChannel(EAsyncTraceType::Single, ArmOrigin, ArmEnd, FQuat::Identity, ProbeChannel, Shape, QueryParams);
+		if (bProbeClearance)
+		{
+			PendingClearanceProbe = World->AsyncSweepByChannel(EAsyncTraceType::Single, ArmOrigin, ArmEnd, FQuat::Identity, ProbeChannel, ClearanceShape, QueryParams);
+		}
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_SkateCameraProbesSync);
+		FHitResult Hit;
+
+		// A clear wide sweep answers for the camera's own sweep too, only a hit needs the exact one
+		if (bProbeClearance && !World->SweepSingleByChannel(Hit, ArmOrigin, ArmEnd, FQuat::Identity, ProbeChannel, ClearanceShape, QueryParams))
+		{
+			ApplyProbeResult(nullptr);
+			bHasClearVolume = true;
+			return;
+		}
+
+		const bool bHit = World->SweepSingleByChannel(Hit, ArmOrigin, ArmEnd, FQuat::Identity, ProbeChannel, Shape, QueryParams);
+		ApplyProbeResult(bHit ? &Hit : nullptr);
+	}
+}
+
+void USkateCameraComponent::ApplyProbeResult(const FHitResult* Hit)
+{
+	bProbeObstructed = Hit != nullptr;
+	ProbeHitFraction = Hit ? Hit->Time : 1.0f;
+}
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "WorldCollision.h"
+#include "SkateCameraComponent.generated.h"
+
+class UCameraComponent;
+
+/**
+ * Camera boom that opens up with speed and airtime, and replaces the spring arm's every-frame
+ * collision sweep with a budgeted one: while the view is clear the probe is swept wider than the
+ * camera, and later arms that stay inside that clear volume reuse it. Probes run as async sweeps
+ * whose results apply next frame.
+ */
+UCLASS(ClassGroup = Camera, meta = (BlueprintSpawnableComponent))
+class SKATEBOARDSIM_API USkateCameraComponent : public USpringArmComponent
+{
+	GENERATED_BODY()
+
+public:
+	USkateCameraComponent();
+
+	/** Speeds that map to the slow and fast ends of the camera ranges (BaseSpeed and 2.1 x BaseSpeed on the skater) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float SlowSpeed;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float FastSpeed;
+
+	/** Arm length at SlowSpeed and FastSpeed. TargetArmLength is driven from these every tick, set these instead */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float SlowArmLength;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float FastArmLength;
+
+	/** Field of view at SlowSpeed and FastSpeed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float SlowFieldOfView;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float FastFieldOfView;
+
+	/** Camera lag speed at SlowSpeed and FastSpeed (lower trails further behind) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float SlowLagSpeed;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float FastLagSpeed;
+
+	/** Extra arm length once fully airborne, and how long it takes to blend in */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Air")
+	float AirArmLengthBonus;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Air")
+	float AirBlendTime;
+
+	/** How quickly arm length, FOV and lag follow their speed targets */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Speed")
+	float ResponseSpeed;
+
+	/** A reused clear volume is re-probed at least every this many frames, in case something moved into it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Collision", meta = (ClampMin = "1"))
+	int32 ClearProbeInterval;
+
+	/**
+	 * While clear, probes are swept this much wider than the camera. Arms whose ends both stay within this
+	 * distance of the probed arm lie inside that clear volume and reuse it; 0 probes every frame.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Collision", meta = (ClampMin = "0"))
+	float ProbeReuseDistance;
+
+	/** Issue probes as async sweeps and apply their results on the next frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Collision")
+	bool bAsyncProbe;
+
+	/** How fast the arm eases back out once an obstruction clears (it always snaps in) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skate Camera|Collision")
+	float ProbeRecoverySpeed;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void OnRegister() override;
+	virtual void UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime) override;
+
+private:
+	/** Moves arm length, FOV and lag towards their targets for the current speed and airtime */
+	void UpdateSpeedTargets(float DeltaTime);
+
+	/** Consumes finished async probes and issues a new one if the budget allows */
+	void UpdateProbe(const FVector& ArmOrigin, const FVector& ArmEnd);
+
+	void ApplyProbeResult(const FHitResult* Hit);
+
+	UPROPERTY(Transient)
+	TWeakObjectPtr<UCameraComponent> FollowCamera;
+
+	/** Arm length the speed and airtime ask for, before any collision */
+	float DesiredArmLength = 0.0f;
+
+	/** Arm length the probes allow, snapped in on a hit and eased out once clear */
+	float ProbedArmLength = 0.0f;
+
+	/** Fraction of the desired arm the last probe found clear, 1 when unobstructed */
+	float ProbeHitFraction = 1.0f;
+
+	float AirTime = 0.0f;
+
+	FTraceHandle PendingProbe;
+
+	/** Wider sweep issued alongside a clear-state probe, a miss makes the probed arm reusable */
+	FTraceHandle PendingClearanceProbe;
+
+	FVector LastProbeOrigin = FVector::ZeroVector;
+	FVector LastProbeEnd = FVector::ZeroVector;
+	int32 FramesSinceProbe = 0;
+	bool bProbeObstructed = false;
+
+	/** Whether the last probed arm, widened by ProbeReuseDistance, was found clear */
+	bool bHasClearVolume = false;
+};
@@ -0,0 +1,253 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SkateMassObstacles.h"
+#include "SkateboardSim.h"
+#include "ObstacleActor.h"
+#include "MassExecutionContext.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mass Obstacle Chunks Scored"), STAT_SkateMassChunksScored, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mass Obstacle Chunks Skipped"), STAT_SkateMassChunksSkipped, STATGROUP_SkateboardSim);
+
+uint32 USkateObstacleScoringProcessor::BoundsGeneration = 1;
+
+namespace SkateMassObstacles
+{
+	/** Recomputes a chunk's XY bounds if entities were created since they were last built */
+	static void UpdateChunkBounds(FMassExecutionContext& Context, FSkateObstacleChunkFragment& Chunk)
+	{
+		if (Chunk.BoundsGeneration == USkateObstacleScoringProcessor::BoundsGeneration)
+		{
+			return;
+		}
+
+		const TConstArrayView<FSkateObstacleBoxesFragment> Boxes = Context.GetFragmentView<FSkateObstacleBoxesFragment>();
+
+		Chunk.BoundsMin = FVector2f(TNumericLimits<float>::Max());
+		Chunk.BoundsMax = FVector2f(TNumericLimits<float>::Lowest());
+		for (const FSkateObstacleBoxesFragment& Box : Boxes)
+		{
+			// Same footprint the grid index uses
+			FVector2f FootprintMin, FootprintMax;
+			FObstacleScoringIndex::GetFootprint(Box.MainCenter, Box.MainExtent, Box.FailCenter, Box.FailExtent, FootprintMin, FootprintMax);
+			Chunk.BoundsMin = FVector2f::Min(Chunk.BoundsMin, FootprintMin);
+			Chunk.BoundsMax = FVector2f::Max(Chunk.BoundsMax, FootprintMax);
+		}
+
+		Chunk.BoundsGeneration = USkateObstacleScoringProcessor::BoundsGeneration;
+	}
+
+	static bool IsNearBounds(const FSkateObstacleChunkFragment& Chunk, const FVector3f& Location, float Radius)
+	{
+		return Location.X >= Chunk.BoundsMin.X - Radius && Location.X <= Chunk.BoundsMax.X + Radius
+			&& Location.Y >= Chunk.BoundsMin.Y - Radius && Location.Y <= Chunk.BoundsMax.Y + Radius;
+	}
+}
+
+USkateObstacleScoringProcessor::USkateObstacleScoringProcessor()
+{
+	// Run by hand from the collision manager, never by the phase graph
+	bAutoRegisterWithProcessingPhases = false;
+	ExecutionFlags = (int32)EProcessorExecutionFlags::All;
+	EntityQuery.RegisterWithProcessor(*this);
+}
+
+void USkateObstacleScoringProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FSkateObstacleTransformFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FSkateObstacleBoxesFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FSkateObstaclePointsFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddChunkRequirement<FSkateObstacleChunkFragment>(EMassFragmentAccess::ReadWrite);
+}
+
+void USkateObstacleScoringProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	if (!Frame)
+	{
+		return;
+	}
+
+	for (FSkateMassScoringSkater& Skater : Frame->Skaters)
+	{
+		Skater.Events->Reset();
+		++Skater.State->Stamp;
+	}
+
+	EntityQuery.ForEachEntityChunk(EntityManager, Context, [this](FMassExecutionContext& ChunkContext)
+	{
+		FSkateObstacleChunkFragment& Chunk = ChunkContext.GetMutableChunkFragment<FSkateObstacleChunkFragment>();
+		SkateMassObstacles::UpdateChunkBounds(ChunkContext, Chunk);
+
+		TArray<int32, TInlineAllocator<8>> NearSkaters;
+		for (int32 SkaterIndex = 0; SkaterIndex < Frame->Skaters.Num(); ++SkaterIndex)
+		{
+			const FSkaterProbe& Probe = Frame->Skaters[SkaterIndex].Probe;
+			if (SkateMassObstacles::IsNearBounds(Chunk, Probe.Location, Probe.Radius))
+			{
+				NearSkaters.Add(SkaterIndex);
+			}
+		}
+
+		// The common case at scale: nobody nearby. Pairs left behind in the chunk are retired after the pass
+		if (NearSkaters.Num() == 0)
+		{
+			INC_DWORD_STAT(STAT_SkateMassChunksSkipped);
+			return;
+		}
+		INC_DWORD_STAT(STAT_SkateMassChunksScored);
+
+		const TConstArrayView<FSkateObstacleTransformFragment> Transforms = ChunkContext.GetFragmentView<FSkateObstacleTransformFragment>();
+		const TConstArrayView<FSkateObstacleBoxesFragment> Boxes = ChunkContext.GetFragmentView<FSkateObstacleBoxesFragment>();
+		const TConstArrayView<FSkateObstaclePointsFragment> Points = ChunkContext.GetFragmentView<FSkateObstaclePointsFragment>();
+
+		for (const int32 SkaterIndex : NearSkaters)
+		{
+			const FSkateMassScoringSkater& Skater = Frame->Skaters[SkaterIndex];
+			FSkaterObstacleState& State = *Skater.State;
+
+			for (int32 EntityIndex = 0; EntityIndex < ChunkContext.GetNumEntities(); ++EntityIndex)
+			{
+				const FSkateObstacleBoxesFragment& Box = Boxes[EntityIndex];
+				const uint8 OverlapBits = FObstacleScoringIndex::TestBoxes(Skater.Probe, Box.MainCenter, Box.MainExtent,
+					Box.FailCenter, Box.FailExtent, Transforms[EntityIndex].Rotation);
+
+				if (OverlapBits == 0 && State.Pairs.Num() == 0)
+				{
+					continue;
+				}
+
+				const FSkateObstaclePointsFragment& Obstacle = Points[EntityIndex];
+				FSkaterObstacleState::FPairState* Pair = State.Pairs.Find(Obstacle.ObstacleIndex);
+				if (!Pair)
+				{
+					if (OverlapBits == 0)
+					{
+						continue;
+					}
+					Pair = &State.Pairs.Add(Obstacle.ObstacleIndex);
+				}
+
+				Pair->Stamp = State.Stamp;
+
+				bool bFailed;
+				bool bCleared;
+				FObstacleScoringIndex::StepPair(*Pair, OverlapBits, Frame->Time, bFailed, bCleared);
+
+				if (bFailed)
+				{
+					Skater.Events->Add({ Obstacle.ObstacleKey, Obstacle.NegativePoints, false });
+				}
+				if (bCleared)
+				{
+					Skater.Events->Add({ Obstacle.ObstacleKey, Obstacle.PositivePoints, true });
+				}
+			}
+		}
+	});
+
+	// Same bookkeeping as the index path, so both keep pairs for exactly as long
+	for (FSkateMassScoringSkater& Skater : Frame->Skaters)
+	{
+		FObstacleScoringIndex::RetireUnvisitedPairs(*Skater.State, Frame->Time);
+	}
+}
+
+bool USkateObstacleScoringProcessor::IsOverlappingAny(FMassEntityManager& EntityManager, const FSkaterProbe& Probe)
+{
+	bool bOverlapping = false;
+
+	FMassExecutionContext Context = EntityManager.CreateExecutionContext(0.0f);
+	EntityQuery.ForEachEntityChunk(EntityManager, Context, [&Probe, &bOverlapping](FMassExecutionContext& ChunkContext)
+	{
+		FSkateObstacleChunkFragment& Chunk = ChunkContext.GetMutableChunkFragment<FSkateObstacleChunkFragment>();
+		SkateMassObstacles::UpdateChunkBounds(ChunkContext, Chunk);
+
+		if (bOverlapping || !SkateMassObstacles::IsNearBounds(Chunk, Probe.Location, Probe.Radius))
+		{
+			return;
+		}
+
+		const TConstArrayView<FSkateObstacleTransformFragment> Transforms = ChunkContext.GetFragmentView<FSkateObstacleTransformFragment>();
+		const TConstArrayView<FSkateObstacleBoxesFragment> Boxes = ChunkContext.GetFragmentView<FSkateObstacleBoxesFragment>();
+
+		for (int32 EntityIndex = 0; EntityIndex < ChunkContext.GetNumEntities() && !bOverlapping; ++EntityIndex)
+		{
+			const FSkateObstacleBoxesFragment& Box = Boxes[EntityIndex];
+			bOverlapping = FObstacleScoringIndex::TestBoxes(Probe, Box.MainCenter, Box.MainExtent,
+				Box.FailCenter, Box.FailExtent, Transforms[EntityIndex].Rotation) != 0;
+		}
+	});
+
+	return bOverlapping;
+}
+
+USkateObstacleVisualLODProcessor::USkateObstacleVisualLODProcessor()
+{
+	bAutoRegisterWithProcessingPhases = false;
+	ExecutionFlags = (int32)EProcessorExecutionFlags::All;
+	bRequiresGameThreadExecution = true;	// Reads actor weak pointers
+	EntityQuery.RegisterWithProcessor(*this);
+}
+
+void USkateObstacleVisualLODProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FSkateObstacleTransformFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FSkateObstacleBoxesFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FSkateObstacleVisualFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddChunkRequirement<FSkateObstacleChunkFragment>(EMassFragmentAccess::ReadWrite);
+}
+
+void USkateObstacleVisualLODProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	if (!Frame)
+	{
+		return;
+	}
+
+	Frame->ToSpawn.Reset();
+	Frame->ToDespawn.Reset();
+
+	EntityQuery.ForEachEntityChunk(EntityManager, Context, [this](FMassExecutionContext& ChunkContext)
+	{
+		FSkateObstacleChunkFragment& Chunk = ChunkContext.GetMutableChunkFragment<FSkateObstacleChunkFragment>();
+		SkateMassObstacles::UpdateChunkBounds(ChunkContext, Chunk);
+
+		if (!Chunk.bHasVisualActors && !SkateMassObstacles::IsNearBounds(Chunk, Frame->ViewLocation, Frame->SpawnRadius))
+		{
+			return;
+		}
+
+		const TConstArrayView<FSkateObstacleTransformFragment> Transforms = ChunkContext.GetFragmentView<FSkateObstacleTransformFragment>();
+		const TConstArrayView<FSkateObstacleVisualFragment> Visuals = ChunkContext.GetFragmentView<FSkateObstacleVisualFragment>();
+
+		const float SpawnRadiusSquared = FMath::Square(Frame->SpawnRadius);
+		const float DespawnRadiusSquared = FMath::Square(Frame->DespawnRadius);
+		bool bHasVisualActors = false;
+
+		for (int32 EntityIndex = 0; EntityIndex < ChunkContext.GetNumEntities(); ++EntityIndex)
+		{
+			const FSkateObstacleVisualFragment& Visual = Visuals[EntityIndex];
+			const float DistanceSquared = FVector3f::DistSquared(Transforms[EntityIndex].Location, Frame->ViewLocation);
+
+			if (Visual.Actor.IsValid())
+			{
+				// Despawning further out than spawning stops actors flickering at the edge
+				if (DistanceSquared > DespawnRadiusSquared)
+				{
+					Frame->ToDespawn.Add(ChunkContext.GetEntity(EntityIndex));
+				}
+				else
+				{
+					bHasVisualActors = true;
+				}
+			}
+			else if (Visual.ActorClass && DistanceSquared < SpawnRadiusSquared)
+			{
+				Frame->ToSpawn.Add(ChunkContext.GetEntity(EntityIndex));
+				bHasVisualActors = true;
+			}
+		}
+
+		Chunk.bHasVisualActors = bHasVisualActors;
+	});
+}
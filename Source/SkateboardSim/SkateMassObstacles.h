@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "MassEntityQuery.h"
+#include "MassProcessor.h"
+#include "ObstacleScoringIndex.h"
+#include "SkateMassObstacles.generated.h"
+
+class AObstacleActor;
+
+/** Where an obstacle sits, also used to place its visuals */
+USTRUCT()
+struct FSkateObstacleTransformFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FVector3f Location = FVector3f::ZeroVector;
+	FQuat4f Rotation = FQuat4f::Identity;
+	FVector3f Scale = FVector3f::OneVector;
+};
+
+/** World space scoring boxes, oriented by the transform's rotation */
+USTRUCT()
+struct FSkateObstacleBoxesFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FVector3f MainCenter = FVector3f::ZeroVector;
+	FVector3f MainExtent = FVector3f::ZeroVector;
+	FVector3f FailCenter = FVector3f::ZeroVector;
+	FVector3f FailExtent = FVector3f::ZeroVector;
+};
+
+USTRUCT()
+struct FSkateObstaclePointsFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	int32 PositivePoints = 0;
+	int32 NegativePoints = 0;
+	uint64 ObstacleKey = 0;
+
+	// Stable for the entity's lifetime, keys each skater's pair state so any number of skaters can be tracked
+	int32 ObstacleIndex = INDEX_NONE;
+};
+
+/** Far visuals are an instance of the type's instanced mesh, near ones a spawned actor */
+USTRUCT()
+struct FSkateObstacleVisualFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	TSubclassOf<AObstacleActor> ActorClass;
+	TWeakObjectPtr<AObstacleActor> Actor;
+	int32 TypeId = 0;
+	int32 InstanceIndex = INDEX_NONE;
+};
+
+/**
+ * Per-chunk summary so passes can skip whole chunks. Obstacles are created in spatial order,
+ * so a chunk covers a compact patch of the level and most chunks are nowhere near a skater.
+ */
+USTRUCT()
+struct FSkateObstacleChunkFragment : public FMassChunkFragment
+{
+	GENERATED_BODY()
+
+	// XY bounds of every main box in the chunk
+	FVector2f BoundsMin = FVector2f::ZeroVector;
+	FVector2f BoundsMax = FVector2f::ZeroVector;
+
+	// Matches USkateObstacleScoringProcessor::BoundsGeneration once the bounds are current
+	uint32 BoundsGeneration = 0;
+
+	// Some obstacle in the chunk has a visual actor spawned
+	bool bHasVisualActors = false;
+};
+
+/** One skater in a scoring pass, its state and events are owned by the collision manager's skater entry */
+struct FSkateMassScoringSkater
+{
+	FSkaterProbe Probe;
+	FSkaterObstacleState* State = nullptr;		// Pairs keyed by FSkateObstaclePointsFragment::ObstacleIndex
+	TArray<FObstacleScoreEvent>* Events = nullptr;	// In chunk order
+};
+
+/** Inputs and outputs of one scoring pass, owned by the collision manager */
+struct FSkateMassScoringFrame
+{
+	TArray<FSkateMassScoringSkater> Skaters;
+	float Time = 0.0f;
+};
+
+/** Inputs and outputs of one visual LOD pass, owned by the collision manager */
+struct FSkateMassVisualFrame
+{
+	FVector3f ViewLocation = FVector3f::ZeroVector;
+	float SpawnRadius = 0.0f;
+	float DespawnRadius = 0.0f;
+
+	TArray<FMassEntityHandle> ToSpawn;
+	TArray<FMassEntityHandle> ToDespawn;
+};
+
+/**
+ * Scores skaters against obstacle entities chunk by chunk. Not part of the processing phases,
+ * the collision manager runs it from its tick so score events merge in the same place as the
+ * batched path.
+ */
+UCLASS()
+class SKATEBOARDSIM_API USkateObstacleScoringProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	USkateObstacleScoringProcessor();
+
+	FSkateMassScoringFrame* Frame = nullptr;
+
+	/** Runs the scoring capsule test against every obstacle near the probe, without touching any pair state */
+	bool IsOverlappingAny(FMassEntityManager& EntityManager, const FSkaterProbe& Probe);
+
+	/** Bump after creating obstacle entities, chunks recompute their bounds on the next pass */
+	static uint32 BoundsGeneration;
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+	FMassEntityQuery EntityQuery;
+};
+
+/** Picks obstacle entities that should gain or lose a spawned visual actor around the view */
+UCLASS()
+class SKATEBOARDSIM_API USkateObstacleVisualLODProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	USkateObstacleVisualLODProcessor();
+
+	FSkateMassVisualFrame* Frame = nullptr;
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+	FMassEntityQuery EntityQuery;
+};
@@ -0,0 +1,507 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SkateRunHistoryStore.h"
+#include "Algo/BinarySearch.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSkateRunHistory, Log, All);
+
+namespace SkateRunHistory
+{
+	static constexpr uint32 FileMagic = 0x48524B53;		// 'SKRH'
+	static constexpr uint32 FileVersion = 2;
+	static constexpr uint32 RecordMagic = 0x4E555252;	// 'RRUN'
+
+	// Guards against reading garbage sizes out of a torn record
+	static constexpr uint32 MaxPayloadSize = 16 * 1024 * 1024;
+
+	struct FFileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+	};
+
+	struct FRecordHeader
+	{
+		uint32 Magic;
+		uint32 PayloadSize;
+		uint32 Crc;
+	};
+
+	/** Validates the record at Offset and returns its payload, or an empty view if it is torn or corrupt */
+	static TArrayView<const uint8> ReadRecord(const uint8* Data, int64 DataSize, int64 Offset)
+	{
+		if (Offset + (int64)sizeof(FRecordHeader) > DataSize)
+		{
+			return {};
+		}
+
+		FRecordHeader Header;
+		FMemory::Memcpy(&Header, Data + Offset, sizeof(Header));
+
+		const int64 PayloadOffset = Offset + sizeof(FRecordHeader);
+		if (Header.Magic != RecordMagic || Header.PayloadSize > MaxPayloadSize || PayloadOffset + Header.PayloadSize > DataSize)
+		{
+			return {};
+		}
+
+		const uint8* Payload = Data + PayloadOffset;
+		if (FCrc::MemCrc32(Payload, Header.PayloadSize) != Header.Crc)
+		{
+			return {};
+		}
+
+		return MakeArrayView(Payload, (int32)Header.PayloadSize);
+	}
+
+	/** Whether the record at Offset was cut short by the end of the file, the only damage an interrupted append leaves */
+	static bool IsTornRecord(const uint8* Data, int64 DataSize, int64 Offset)
+	{
+		if (Offset + (int64)sizeof(FRecordHeader) > DataSize)
+		{
+			return true;
+		}
+
+		FRecordHeader Header;
+		FMemory::Memcpy(&Header, Data + Offset, sizeof(Header));
+		return Header.Magic == RecordMagic && Header.PayloadSize <= MaxPayloadSize
+			&& Offset + (int64)sizeof(FRecordHeader) + Header.PayloadSize > DataSize;
+	}
+
+	/** Offset of the first valid record after Offset, or INDEX_NONE if there is none */
+	static int64 FindNextRecord(const uint8* Data, int64 DataSize, int64 Offset)
+	{
+		for (int64 Candidate = Offset + 1; Candidate + (int64)sizeof(FRecordHeader) <= DataSize; ++Candidate)
+		{
+			uint32 Magic;
+			FMemory::Memcpy(&Magic, Data + Candidate, sizeof(Magic));
+			if (Magic == RecordMagic && ReadRecord(Data, DataSize, Candidate).Num() > 0)
+			{
+				return Candidate;
+			}
+		}
+		return INDEX_NONE;
+	}
+}
+
+FSkateRunHistoryStore::FSkateRunHistoryStore(const FString& InFilename)
+	: Filename(InFilename)
+	, IOPipe(TEXT("SkateRunHistory"))
+{
+}
+
+FSkateRunHistoryStore::~FSkateRunHistoryStore()
+{
+	// Pipe tasks reference this store, let every queued write land first
+	Flush();
+	WriteHandle.Reset();
+	ReleaseLog();
+}
+
+void FSkateRunHistoryStore::OpenAsync()
+{
+	IOPipe.Launch(TEXT("SkateRunHistory.Open"), [this]() { OpenLog(); });
+}
+
+void FSkateRunHistoryStore::AppendRunAsync(FSkateRunSummary Summary, TArray<FSkateObstacleEvent> Events)
+{
+	IOPipe.Launch(TEXT("SkateRunHistory.Append"), [this, Summary = MoveTemp(Summary), Events = MoveTemp(Events)]() mutable
+	{
+		WriteRun(Summary, Events);
+	});
+}
+
+void FSkateRunHistoryStore::Flush()
+{
+	IOPipe.WaitUntilEmpty();
+}
+
+void FSkateRunHistoryStore::OpenLog()
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	// Claimed before anything can move or truncate the log under another process
+	bOwnsLog = ClaimLog();
+
+	FIndex NewIndex;
+	int64 AppendOffset = 0;
+	const EScanResult ScanResult = RebuildIndex(NewIndex, AppendOffset);
+
+	bool bCanAppend = true;
+	if (!bOwnsLog)
+	{
+		UE_LOG(LogSkateRunHistory, Error, TEXT("Run history '%s' is in use by another process, runs from this session will not be saved."), *Filename);
+		bCanAppend = false;
+	}
+	else if (ScanResult == EScanResult::MapFailed)
+	{
+		// The file may be perfectly good, leave it untouched and keep this session read-only
+		UE_LOG(LogSkateRunHistory, Error, TEXT("Run history '%s' could not be mapped, runs from this session will not be saved."), *Filename);
+		bCanAppend = false;
+	}
+	else if (ScanResult == EScanResult::UnknownFormat)
+	{
+		// Unknown format or version, keep it aside rather than appending to something we cannot read
+		bCanAppend = QuarantineLog();
+		AppendOffset = 0;
+	}
+
+	if (bCanAppend)
+	{
+		WriteHandle.Reset(PlatformFile.OpenWrite(*Filename, /*bAppend*/ true, /*bAllowRead*/ true));
+		UE_CLOG(!WriteHandle, LogSkateRunHistory, Error, TEXT("Could not open run history '%s' for writing."), *Filename);
+	}
+
+	if (WriteHandle)
+	{
+		// A crash mid-append leaves a torn record at the tail, drop it so new records follow the last good one.
+		// Nothing else is ever cut, the scan only stops short of the end of the file for a torn tail.
+		if (WriteHandle->Size() > AppendOffset)
+		{
+			UE_LOG(LogSkateRunHistory, Warning, TEXT("Discarding a torn %lld byte record at the end of run history."), WriteHandle->Size() - AppendOffset);
+			WriteHandle->Truncate(AppendOffset);
+		}
+		WriteHandle->Seek(AppendOffset);
+
+		if (AppendOffset == 0)
+		{
+			SkateRunHistory::FFileHeader Header { SkateRunHistory::FileMagic, SkateRunHistory::FileVersion };
+			WriteHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+			WriteHandle->Flush();
+		}
+	}
+	bWritable = WriteHandle.IsValid();
+
+	{
+		FRWScopeLock Lock(IndexLock, SLT_Write);
+		Index = MoveTemp(NewIndex);
+	}
+
+	bReady = true;
+	UE_LOG(LogSkateRunHistory, Log, TEXT("Run history ready with %lld runs."), GetNumRuns());
+}
+
+bool FSkateRunHistoryStore::QuarantineLog()
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Timestamped so an earlier unreadable log is never overwritten, numbered in case two land in the same second
+	const FString BaseFilename = FString::Printf(TEXT("%s.%s.unreadable"), *Filename, *FDateTime::Now().ToString());
+	FString BackupFilename = BaseFilename;
+	for (int32 Suffix = 1; PlatformFile.FileExists(*BackupFilename); ++Suffix)
+	{
+		BackupFilename = FString::Printf(TEXT("%s.%d"), *BaseFilename, Suffix);
+	}
+
+	if (!PlatformFile.MoveFile(*BackupFilename, *Filename))
+	{
+		UE_LOG(LogSkateRunHistory, Error, TEXT("Run history '%s' is unreadable and could not be moved aside, runs from this session will not be saved."), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogSkateRunHistory, Warning, TEXT("Run history '%s' is unreadable, moved it to '%s'."), *Filename, *BackupFilename);
+	return true;
+}
+
+bool FSkateRunHistoryStore::ClaimLog()
+{
+	const FString LockFilename = Filename + TEXT(".lock");
+	const uint32 ProcessId = FPlatformProcess::GetCurrentProcessId();
+
+	// A lock left behind by a crashed process names a process that is no longer running
+	FString Owner;
+	if (FFileHelper::LoadFileToString(Owner, *LockFilename))
+	{
+		const uint32 OwnerId = (uint32)FCString::Strtoui64(*Owner, nullptr, 10);
+		if (OwnerId != ProcessId && FPlatformProcess::IsApplicationRunning(OwnerId))
+		{
+			return false;
+		}
+	}
+
+	// Read back in case another process started at the same moment and wrote its own id last
+	if (!FFileHelper::SaveStringToFile(LexToString(ProcessId), *LockFilename)
+		|| !FFileHelper::LoadFileToString(Owner, *LockFilename))
+	{
+		return false;
+	}
+	return (uint32)FCString::Strtoui64(*Owner, nullptr, 10) == ProcessId;
+}
+
+void FSkateRunHistoryStore::ReleaseLog()
+{
+	if (bOwnsLog)
+	{
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*(Filename + TEXT(".lock")));
+		bOwnsLog = false;
+	}
+}
+
+FSkateRunHistoryStore::EScanResult FSkateRunHistoryStore::RebuildIndex(FIndex& OutIndex, int64& OutAppendOffset)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	OutAppendOffset = 0;
+
+	const int64 FileSize = PlatformFile.FileSize(*Filename);
+	if (FileSize < (int64)sizeof(SkateRunHistory::FFileHeader))
+	{
+		// Missing or never got past its header, start over
+		return EScanResult::Ok;
+	}
+
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Filename));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile ? MappedFile->MapRegion(0, FileSize) : nullptr);
+	if (!MappedRegion)
+	{
+		return EScanResult::MapFailed;
+	}
+
+	const uint8* Data = MappedRegion->GetMappedPtr();
+	const int64 DataSize = MappedRegion->GetMappedSize();
+
+	SkateRunHistory::FFileHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+	if (Header.Magic != SkateRunHistory::FileMagic || Header.Version != SkateRunHistory::FileVersion)
+	{
+		return EScanResult::UnknownFormat;
+	}
+
+	int64 Offset = sizeof(SkateRunHistory::FFileHeader);
+	int32 NumCorrupt = 0;
+	FSkateRunSummary Summary;
+	TArray<FSkateObstacleEvent> Events;
+
+	while (Offset < DataSize)
+	{
+		const TArrayView<const uint8> Payload = SkateRunHistory::ReadRecord(Data, DataSize, Offset);
+		if (Payload.Num() > 0)
+		{
+			FMemoryReaderView Reader(Payload);
+			SerializeRun(Reader, Summary, Events);
+			if (!Reader.IsError())
+			{
+				Summary.RecordOffset = Offset;
+				OutIndex.Add(Summary, Events);
+				NextRunId = FMath::Max(NextRunId, Summary.RunId + 1);
+
+				Offset += sizeof(SkateRunHistory::FRecordHeader) + Payload.Num();
+				continue;
+			}
+		}
+
+		// Damage in the middle of the log costs only the damaged record, the scan picks up at the next good one
+		const int64 NextOffset = SkateRunHistory::FindNextRecord(Data, DataSize, Offset);
+		if (NextOffset != INDEX_NONE)
+		{
+			++NumCorrupt;
+			Offset = NextOffset;
+			continue;
+		}
+
+		// Nothing valid follows. A torn tail is safe to drop; anything else stays on disk and new records go after it
+		if (!SkateRunHistory::IsTornRecord(Data, DataSize, Offset))
+		{
+			++NumCorrupt;
+			Offset = DataSize;
+		}
+		break;
+	}
+
+	UE_CLOG(NumCorrupt > 0, LogSkateRunHistory, Warning, TEXT("Skipped %d corrupt records in run history '%s', they are left in place."), NumCorrupt, *Filename);
+
+	OutAppendOffset = Offset;
+	return EScanResult::Ok;
+}
+
+void FSkateRunHistoryStore::WriteRun(FSkateRunSummary& Summary, TArray<FSkateObstacleEvent>& Events)
+{
+	if (!WriteHandle)
+	{
+		return;
+	}
+
+	Summary.RunId = NextRunId++;
+
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	SerializeRun(Writer, Summary, Events);
+
+	const SkateRunHistory::FRecordHeader Header { SkateRunHistory::RecordMagic, (uint32)Payload.Num(), FCrc::MemCrc32(Payload.GetData(), Payload.Num()) };
+
+	const int64 RecordOffset = WriteHandle->Tell();
+	const bool bWritten = WriteHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header))
+		&& WriteHandle->Write(Payload.GetData(), Payload.Num())
+		&& WriteHandle->Flush();
+
+	if (!bWritten)
+	{
+		// Leave the torn tail for the next open to discard, but keep this session's index consistent with disk
+		UE_LOG(LogSkateRunHistory, Error, TEXT("Failed to append run %lld to '%s'."), Summary.RunId, *Filename);
+		WriteHandle.Reset();
+		bWritable = false;
+		return;
+	}
+
+	Summary.RecordOffset = RecordOffset;
+
+	FRWScopeLock Lock(IndexLock, SLT_Write);
+	Index.Add(Summary, Events);
+}
+
+void FSkateRunHistoryStore::SerializeRun(FArchive& Ar, FSkateRunSummary& Summary, TArray<FSkateObstacleEvent>& Events)
+{
+	Ar << Summary.RunId;
+	Ar << Summary.Timestamp;
+	Ar << Summary.PlayerName;
+	Ar << Summary.FinalScore;
+	Ar << Summary.DurationSeconds;
+	Ar << Summary.NumCleared;
+	Ar << Summary.NumFailed;
+
+	int32 NumEvents = Events.Num();
+	Ar << NumEvents;
+
+	if (Ar.IsLoading())
+	{
+		// Each event takes 17 bytes, anything claiming more than the payload holds is corrupt
+		if (NumEvents < 0 || NumEvents > (Ar.TotalSize() - Ar.Tell()) / 17)
+		{
+			Ar.SetError();
+			return;
+		}
+		Events.SetNumUninitialized(NumEvents, false);
+	}
+
+	for (FSkateObstacleEvent& Event : Events)
+	{
+		uint8 bCleared = Event.bCleared ? 1 : 0;
+		Ar << Event.ObstacleKey;
+		Ar << Event.TimeOffset;
+		Ar << Event.Points;
+		Ar << bCleared;
+		Event.bCleared = bCleared != 0;
+	}
+}
+
+void FSkateRunHistoryStore::FIndex::Add(const FSkateRunSummary& Summary, const TArray<FSkateObstacleEvent>& Events)
+{
+	++NumRuns;
+
+	// Most runs do not make the board, so the common case is a single comparison
+	if (Leaderboard.Num() < LeaderboardCapacity || Summary.FinalScore > Leaderboard.Last().FinalScore)
+	{
+		// Upper bound keeps older runs ahead of newer ones on equal scores
+		const int32 InsertIndex = Algo::UpperBound(Leaderboard, Summary, [](const FSkateRunSummary& A, const FSkateRunSummary& B)
+		{
+			return A.FinalScore > B.FinalScore;
+		});
+		Leaderboard.Insert(Summary, InsertIndex);
+
+		if (Leaderboard.Num() > LeaderboardCapacity)
+		{
+			Leaderboard.Pop(false);
+		}
+	}
+
+	FSkateRunSummary* Best = PersonalBests.Find(Summary.PlayerName);
+	if (!Best)
+	{
+		PersonalBests.Add(Summary.PlayerName, Summary);
+	}
+	else if (Summary.FinalScore > Best->FinalScore)
+	{
+		*Best = Summary;
+	}
+
+	for (const FSkateObstacleEvent& Event : Events)
+	{
+		FSkateObstacleStats& Stats = ObstacleStats.FindOrAdd(Event.ObstacleKey);
+		++Stats.Attempts;
+		Stats.Clears += Event.bCleared ? 1 : 0;
+	}
+}
+
+void FSkateRunHistoryStore::GetTopRuns(int32 K, TArray<FSkateRunSummary>& OutRuns) const
+{
+	FRWScopeLock Lock(IndexLock, SLT_ReadOnly);
+
+	const int32 Count = FMath::Clamp(K, 0, Index.Leaderboard.Num());
+	OutRuns.Reset(Count);
+	OutRuns.Append(Index.Leaderboard.GetData(), Count);
+}
+
+bool FSkateRunHistoryStore::GetPersonalBest(const FString& PlayerName, FSkateRunSummary& OutRun) const
+{
+	FRWScopeLock Lock(IndexLock, SLT_ReadOnly);
+
+	if (const FSkateRunSummary* Best = Index.PersonalBests.Find(PlayerName))
+	{
+		OutRun = *Best;
+		return true;
+	}
+	return false;
+}
+
+bool FSkateRunHistoryStore::GetObstacleStats(uint64 ObstacleKey, FSkateObstacleStats& OutStats) const
+{
+	FRWScopeLock Lock(IndexLock, SLT_ReadOnly);
+
+	if (const FSkateObstacleStats* Stats = Index.ObstacleStats.Find(ObstacleKey))
+	{
+		OutStats = *Stats;
+		return true;
+	}
+	return false;
+}
+
+int64 FSkateRunHistoryStore::GetNumRuns() const
+{
+	FRWScopeLock Lock(IndexLock, SLT_ReadOnly);
+	return Index.NumRuns;
+}
+
+bool FSkateRunHistoryStore::LoadRunEvents(const FSkateRunSummary& Run, TArray<FSkateObstacleEvent>& OutEvents) const
+{
+	OutEvents.Reset();
+
+	if (Run.RecordOffset == INDEX_NONE)
+	{
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Only map up to the current end of the log, the pipe may be appending beyond it
+	const int64 FileSize = PlatformFile.FileSize(*Filename);
+	if (Run.RecordOffset >= FileSize)
+	{
+		return false;
+	}
+
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Filename));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile ? MappedFile->MapRegion(Run.RecordOffset, FileSize - Run.RecordOffset) : nullptr);
+	if (!MappedRegion)
+	{
+		return false;
+	}
+
+	const TArrayView<const uint8> Payload = SkateRunHistory::ReadRecord(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize(), 0);
+	if (Payload.Num() == 0)
+	{
+		return false;
+	}
+
+	FSkateRunSummary Summary;
+	FMemoryReaderView Reader(Payload);
+	SerializeRun(Reader, Summary, OutEvents);
+
+	return !Reader.IsError() && Summary.RunId == Run.RunId;
+}
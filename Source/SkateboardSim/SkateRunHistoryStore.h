@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/DateTime.h"
+#include "Tasks/Pipe.h"
+#include "SkateRunHistoryStore.generated.h"
+
+class IFileHandle;
+
+/** Summary of one finished run, as stored in the history log */
+USTRUCT(BlueprintType)
+struct SKATEBOARDSIM_API FSkateRunSummary
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Run History")
+	int64 RunId = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Run History")
+	FDateTime Timestamp;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Run History")
+	FString PlayerName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Run History")
+	int32 FinalScore = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Run History")
+	float DurationSeconds = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Run History")
+	int32 NumCleared = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Run History")
+	int32 NumFailed = 0;
+
+	/** Where the full record lives in the log, used to read its events back */
+	int64 RecordOffset = INDEX_NONE;
+};
+
+/** One obstacle clear or fail inside a run */
+struct FSkateObstacleEvent
+{
+	uint64 ObstacleKey = 0;
+	float TimeOffset = 0.0f;		// Seconds since the run started
+	int32 Points = 0;				// Points actually applied (negative for a fail)
+	bool bCleared = false;
+};
+
+/** Aggregated results for one obstacle across the whole history */
+struct FSkateObstacleStats
+{
+	int32 Attempts = 0;
+	int32 Clears = 0;
+
+	float GetSuccessRate() const { return Attempts > 0 ? (float)Clears / Attempts : 0.0f; }
+};
+
+/**
+ * Append-only, checksummed run log with an in-memory index rebuilt from it on open.
+ * All file IO runs in order on a background pipe so the game thread never waits on disk;
+ * queries only read the index and never scan the history.
+ */
+class SKATEBOARDSIM_API FSkateRunHistoryStore
+{
+public:
+	/** Number of best runs kept sorted for leaderboard queries */
+	static constexpr int32 LeaderboardCapacity = 1024;
+
+	explicit FSkateRunHistoryStore(const FString& InFilename);
+	~FSkateRunHistoryStore();
+
+	/** Rebuilds the index from the log in the background, queries are empty until this completes */
+	void OpenAsync();
+
+	/** Queues a finished run to be appended to the log and indexed */
+	void AppendRunAsync(FSkateRunSummary Summary, TArray<FSkateObstacleEvent> Events);
+
+	/** Blocks until every queued write has hit the disk */
+	void Flush();
+
+	bool IsReady() const { return bReady; }
+
+	/** False once the log turns out to be owned by another process or cannot be written, runs are then not saved */
+	bool IsWritable() const { return bWritable; }
+
+	/** Best K runs, highest score first */
+	void GetTopRuns(int32 K, TArray<FSkateRunSummary>& OutRuns) const;
+
+	bool GetPersonalBest(const FString& PlayerName, FSkateRunSummary& OutRun) const;
+
+	bool GetObstacleStats(uint64 ObstacleKey, FSkateObstacleStats& OutStats) const;
+
+	int64 GetNumRuns() const;
+
+	/** Reads a run's events back from the log through a memory mapping */
+	bool LoadRunEvents(const FSkateRunSummary& Run, TArray<FSkateObstacleEvent>& OutEvents) const;
+
+private:
+	/** Everything queries need, kept small enough that no query touches the log */
+	struct FIndex
+	{
+		TArray<FSkateRunSummary> Leaderboard;			// Sorted best first, capped at LeaderboardCapacity
+		TMap<FString, FSkateRunSummary> PersonalBests;
+		TMap<uint64, FSkateObstacleStats> ObstacleStats;
+		int64 NumRuns = 0;
+
+		void Add(const FSkateRunSummary& Summary, const TArray<FSkateObstacleEvent>& Events);
+	};
+
+	enum class EScanResult : uint8
+	{
+		Ok,
+		UnknownFormat,	// Wrong magic or version, safe to set aside
+		MapFailed,		// Could not be read this session, says nothing about its contents
+	};
+
+	/**
+	 * Scans the mapped log into OutIndex, skipping over corrupt records. OutAppendOffset is where new records go:
+	 * the end of the file, or the start of a torn record left at the end by an interrupted append.
+	 */
+	EScanResult RebuildIndex(FIndex& OutIndex, int64& OutAppendOffset);
+
+	/** Moves an unreadable log aside under a timestamped name, never replacing an earlier backup */
+	bool QuarantineLog();
+
+	/**
+	 * Takes the lock file next to the log for this process. Fails while another running process holds it,
+	 * since two writers appending to one log would overwrite each other's records.
+	 */
+	bool ClaimLog();
+	void ReleaseLog();
+
+	void OpenLog();
+
+	void WriteRun(FSkateRunSummary& Summary, TArray<FSkateObstacleEvent>& Events);
+
+	static void SerializeRun(FArchive& Ar, FSkateRunSummary& Summary, TArray<FSkateObstacleEvent>& Events);
+
+	FString Filename;
+
+	/** Runs every file operation in submission order off the game thread */
+	UE::Tasks::FPipe IOPipe;
+
+	/** Only ever touched from pipe tasks */
+	TUniquePtr<IFileHandle> WriteHandle;
+	int64 NextRunId = 1;
+	bool bOwnsLog = false;
+
+	/** Written from the pipe, read from the game thread; held only for in-memory updates, never for IO */
+	mutable FRWLock IndexLock;
+	FIndex Index;
+
+	std::atomic<bool> bReady { false };
+	std::atomic<bool> bWritable { false };
+};
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SkateRunHistorySubsystem.h"
+#include "Misc/Paths.h"
+
+bool USkateRunHistorySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Commandlets such as the obstacle bake have no runs to record and must not contend for the log
+	return !IsRunningCommandlet() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void USkateRunHistorySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Store = MakeUnique<FSkateRunHistoryStore>(FPaths::ProjectSavedDir() / TEXT("RunHistory") / TEXT("RunHistory.bin"));
+	Store->OpenAsync();
+}
+
+void USkateRunHistorySubsystem::Deinitialize()
+{
+	// Waits for any queued runs to be written out
+	Store.Reset();
+
+	Super::Deinitialize();
+}
+
+void USkateRunHistorySubsystem::SubmitRun(FSkateRunSummary Summary, TArray<FSkateObstacleEvent> Events)
+{
+	if (Store)
+	{
+		UE_CLOG(Store->IsReady() && !Store->IsWritable(), LogTemp, Warning, TEXT("Run history is read-only this session, the run by %s will not be saved."), *Summary.PlayerName);
+
+		Summary.Timestamp = FDateTime::UtcNow();
+		Store->AppendRunAsync(MoveTemp(Summary), MoveTemp(Events));
+	}
+}
+
+TArray<FSkateRunSummary> USkateRunHistorySubsystem::GetTopRuns(int32 Count) const
+{
+	TArray<FSkateRunSummary> Runs;
+	if (Store)
+	{
+		Store->GetTopRuns(Count, Runs);
+	}
+	return Runs;
+}
+
+bool USkateRunHistorySubsystem::GetPersonalBest(const FString& PlayerName, FSkateRunSummary& OutRun) const
+{
+	return Store && Store->GetPersonalBest(PlayerName, OutRun);
+}
+
+float USkateRunHistorySubsystem::GetObstacleSuccessRate(int64 ObstacleKey) const
+{
+	FSkateObstacleStats Stats;
+	return Store && Store->GetObstacleStats((uint64)ObstacleKey, Stats) ? Stats.GetSuccessRate() : 0.0f;
+}
+
+int64 USkateRunHistorySubsystem::GetNumStoredRuns() const
+{
+	return Store ? Store->GetNumRuns() : 0;
+}
+
+bool USkateRunHistorySubsystem::IsHistoryReady() const
+{
+	return Store && Store->IsReady();
+}
+
+bool USkateRunHistorySubsystem::IsHistoryWritable() const
+{
+	return Store && Store->IsWritable();
+}
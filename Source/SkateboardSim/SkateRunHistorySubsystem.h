@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "SkateRunHistoryStore.h"
+#include "SkateRunHistorySubsystem.generated.h"
+
+/**
+ * Owns the local run history for the lifetime of the process and exposes
+ * leaderboard, personal best and per-obstacle queries to gameplay and UI.
+ * One store per process, so every PIE client shares it rather than opening the log twice.
+ */
+UCLASS()
+class SKATEBOARDSIM_API USkateRunHistorySubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Stamps and queues a finished run; returns immediately, the write happens in the background */
+	void SubmitRun(FSkateRunSummary Summary, TArray<FSkateObstacleEvent> Events);
+
+	/** Best runs recorded on this machine, highest score first */
+	UFUNCTION(BlueprintCallable, Category = "Run History")
+	TArray<FSkateRunSummary> GetTopRuns(int32 Count) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Run History")
+	bool GetPersonalBest(const FString& PlayerName, FSkateRunSummary& OutRun) const;
+
+	/** Fraction of attempts on this obstacle that were cleared, 0 if it was never attempted */
+	UFUNCTION(BlueprintCallable, Category = "Run History")
+	float GetObstacleSuccessRate(int64 ObstacleKey) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Run History")
+	int64 GetNumStoredRuns() const;
+
+	/** False until the history has been indexed after startup */
+	UFUNCTION(BlueprintCallable, Category = "Run History")
+	bool IsHistoryReady() const;
+
+	/** False when runs from this session cannot be saved, e.g. another game process holds the history */
+	UFUNCTION(BlueprintCallable, Category = "Run History")
+	bool IsHistoryWritable() const;
+
+	const FSkateRunHistoryStore* GetStore() const { return Store.Get(); }
+
+private:
+	TUniquePtr<FSkateRunHistoryStore> Store;
+};
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SkateScoreHUD.h"
+#include "SSkateScoreDisplay.h"
+#include "ObstacleCollisionManager.h"
+#include "EngineUtils.h"
+#include "Slate/SRetainerWidget.h"
+#include "Styling/CoreStyle.h"
+#include "Widgets/SInvalidationPanel.h"
+
+#define LOCTEXT_NAMESPACE "SkateScoreHUD"
+
+USkateScoreHUD::USkateScoreHUD()
+{
+	Font = FCoreStyle::GetDefaultFontStyle("Bold", 32);
+	ScoreColor = FLinearColor::White;
+	GainColor = FLinearColor(0.2f, 1.0f, 0.2f);
+	LossColor = FLinearColor(1.0f, 0.2f, 0.2f);
+	TrickColor = FLinearColor(1.0f, 0.85f, 0.1f);
+	bRetainRendering = false;
+}
+
+TSharedRef<SWidget> USkateScoreHUD::RebuildWidget()
+{
+	ScoreDisplay = SNew(SSkateScoreDisplay)
+		.Font(Font)
+		.ScoreColor(ScoreColor)
+		.GainColor(GainColor)
+		.LossColor(LossColor)
+		.TrickColor(TrickColor);
+
+	if (!IsDesignTime())
+	{
+		if (BoundManager.IsValid())
+		{
+			ScoreDisplay->SetScore(BoundManager->GetCurrentScore());
+		}
+		else if (UWorld* World = GetWorld())
+		{
+			TActorIterator<AObstacleCollisionManager> It(World);
+			if (It)
+			{
+				BindToCollisionManager(*It);
+			}
+		}
+	}
+
+	// Either root caches the readout's draw elements, so the rest of the HUD never sees score churn
+	if (bRetainRendering)
+	{
+		return SNew(SRetainerWidget)
+			.RenderOnInvalidation(true)
+			.RenderOnPhase(false)
+			[
+				ScoreDisplay.ToSharedRef()
+			];
+	}
+
+	return SNew(SInvalidationPanel)
+		[
+			ScoreDisplay.ToSharedRef()
+		];
+}
+
+void USkateScoreHUD::SynchronizeProperties()
+{
+	Super::SynchronizeProperties();
+
+	if (ScoreDisplay.IsValid())
+	{
+		ScoreDisplay->SetFont(Font);
+		ScoreDisplay->SetColors(ScoreColor, GainColor, LossColor, TrickColor);
+	}
+}
+
+void USkateScoreHUD::ReleaseSlateResources(bool bReleaseChildren)
+{
+	Super::ReleaseSlateResources(bReleaseChildren);
+
+	ScoreDisplay.Reset();
+}
+
+void USkateScoreHUD::BindToCollisionManager(AObstacleCollisionManager* Manager)
+{
+	if (AObstacleCollisionManager* OldManager = BoundManager.Get())
+	{
+		OldManager->OnScoreUpdated.RemoveDynamic(this, &USkateScoreHUD::HandleScoreUpdated);
+	}
+
+	BoundManager = Manager;
+
+	if (Manager)
+	{
+		Manager->OnScoreUpdated.AddUniqueDynamic(this, &USkateScoreHUD::HandleScoreUpdated);
+
+		if (ScoreDisplay.IsValid())
+		{
+			ScoreDisplay->SetScore(Manager->GetCurrentScore());
+		}
+	}
+}
+
+void USkateScoreHUD::SetTrickName(const FText& TrickName)
+{
+	if (ScoreDisplay.IsValid())
+	{
+		ScoreDisplay->QueueTrickName(TrickName.ToString());
+	}
+}
+
+void USkateScoreHUD::HandleScoreUpdated(int32 NewScore)
+{
+	// Only queued here, the display applies everything from this frame in one pass
+	if (ScoreDisplay.IsValid())
+	{
+		ScoreDisplay->QueueScore(NewScore);
+	}
+}
+
+#if WITH_EDITOR
+const FText USkateScoreHUD::GetPaletteCategory()
+{
+	return LOCTEXT("SkateboardSim", "Skateboard Sim");
+}
+#endif
+
+#undef LOCTEXT_NAMESPACE
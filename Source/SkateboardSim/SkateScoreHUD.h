@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/Widget.h"
+#include "Fonts/SlateFontInfo.h"
+#include "SkateScoreHUD.generated.h"
+
+class SSkateScoreDisplay;
+class AObstacleCollisionManager;
+
+/**
+ * Native score and trick readout for WB_MainHUD. Wraps SSkateScoreDisplay in an invalidation root
+ * so the HUD only repaints when the score actually changes.
+ */
+UCLASS()
+class SKATEBOARDSIM_API USkateScoreHUD : public UWidget
+{
+	GENERATED_BODY()
+
+public:
+	USkateScoreHUD();
+
+	/** Font used for every line of the readout */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateFontInfo Font;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FLinearColor ScoreColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FLinearColor GainColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FLinearColor LossColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FLinearColor TrickColor;
+
+	/** Render into a retainer target that is only redrawn on invalidation, instead of a plain invalidation panel */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Performance")
+	bool bRetainRendering;
+
+	/** Listens to a collision manager's score updates (the first one in the world is bound automatically) */
+	UFUNCTION(BlueprintCallable, Category = "Score")
+	void BindToCollisionManager(AObstacleCollisionManager* Manager);
+
+	/** Shows the name of the last trick landed */
+	UFUNCTION(BlueprintCallable, Category = "Score")
+	void SetTrickName(const FText& TrickName);
+
+	// UWidget interface
+	virtual void SynchronizeProperties() override;
+	virtual void ReleaseSlateResources(bool bReleaseChildren) override;
+
+#if WITH_EDITOR
+	virtual const FText GetPaletteCategory() override;
+#endif
+
+protected:
+	// UWidget interface
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+
+	UFUNCTION()
+	void HandleScoreUpdated(int32 NewScore);
+
+private:
+	TSharedPtr<SSkateScoreDisplay> ScoreDisplay;
+
+	UPROPERTY(Transient)
+	TWeakObjectPtr<AObstacleCollisionManager> BoundManager;
+};
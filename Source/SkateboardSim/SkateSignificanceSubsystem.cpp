@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SkateSignificanceSubsystem.h"
+#include "SkateboardSim.h"
+#include "ObstacleActor.h"
+#include "SkateboardSimCharacter.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_SkateSignificanceUpdate, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Obstacles Full"), STAT_SkateObstaclesFull, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Obstacles Reduced"), STAT_SkateObstaclesReduced, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Obstacles Dormant"), STAT_SkateObstaclesDormant, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Significance Changes"), STAT_SkateSignificanceChanges, STATGROUP_SkateboardSim);
+
+static TAutoConsoleVariable<bool> CVarSignificanceEnabled(
+	TEXT("skate.Significance.Enabled"),
+	true,
+	TEXT("When false every registered actor is kept at full significance."));
+
+static TAutoConsoleVariable<float> CVarSignificanceUpdateInterval(
+	TEXT("skate.Significance.UpdateInterval"),
+	0.25f,
+	TEXT("Seconds between significance re-evaluations."));
+
+// At MaxSpeed (2.1 x 500) a skater covers ~260 units between updates, so the full ring keeps a wide margin
+static TAutoConsoleVariable<float> CVarSignificanceFullRadius(
+	TEXT("skate.Significance.FullRadius"),
+	2500.0f,
+	TEXT("Obstacles closer than this to any skater, and remote skaters this close to the local one, always do full work."));
+
+static TAutoConsoleVariable<float> CVarSignificanceReducedRadius(
+	TEXT("skate.Significance.ReducedRadius"),
+	8000.0f,
+	TEXT("Actors inside this radius run throttled; beyond it they go dormant. Remote skaters scale it by view relevance."));
+
+static TAutoConsoleVariable<float> CVarSignificanceBehindScale(
+	TEXT("skate.Significance.BehindScale"),
+	2.0f,
+	TEXT("Distance multiplier applied to remote skaters directly behind the view when ranking the reduced ring."));
+
+void USkateSignificanceSubsystem::Deinitialize()
+{
+	Obstacles.Reset();
+	ObstacleIndices.Reset();
+	Skaters.Reset();
+
+	Super::Deinitialize();
+}
+
+bool USkateSignificanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USkateSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USkateSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+void USkateSignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate >= CVarSignificanceUpdateInterval.GetValueOnGameThread())
+	{
+		TimeSinceUpdate = 0.0f;
+		UpdateSignificance();
+	}
+}
+
+void USkateSignificanceSubsystem::RegisterObstacle(AObstacleActor* Obstacle)
+{
+	if (!Obstacle || ObstacleIndices.Contains(Obstacle))
+	{
+		return;
+	}
+
+	// Obstacles are static, so their location is cached once here
+	const int32 Index = Obstacles.Add({ Obstacle, Obstacle->GetActorLocation(), ESkateSignificance::Full });
+	ObstacleIndices.Add(Obstacle, Index);
+	RequestUpdate();
+}
+
+void USkateSignificanceSubsystem::UnregisterObstacle(AObstacleActor* Obstacle)
+{
+	int32 Index;
+	if (!ObstacleIndices.RemoveAndCopyValue(Obstacle, Index))
+	{
+		return;
+	}
+
+	Obstacles.RemoveAtSwap(Index, 1, false);
+
+	// Patch the index of the entry that was swapped into the freed slot
+	if (Obstacles.IsValidIndex(Index))
+	{
+		if (const AObstacleActor* Moved = Obstacles[Index].Obstacle.Get())
+		{
+			ObstacleIndices.Add(Moved, Index);
+		}
+	}
+}
+
+void USkateSignificanceSubsystem::RegisterSkater(ASkateboardSimCharacter* Skater)
+{
+	if (Skater && !Skaters.ContainsByPredicate([Skater](const FSkaterEntry& Entry) { return Entry.Skater == Skater; }))
+	{
+		Skaters.Add({ Skater, ESkateSignificance::Full });
+		RequestUpdate();
+	}
+}
+
+void USkateSignificanceSubsystem::UnregisterSkater(ASkateboardSimCharacter* Skater)
+{
+	Skaters.RemoveAllSwap([Skater](const FSkaterEntry& Entry) { return Entry.Skater == Skater; });
+}
+
+ESkateSignificance USkateSignificanceSubsystem::ClassifyDistance(float DistanceSq) const
+{
+	if (DistanceSq <= FMath::Square(CVarSignificanceFullRadius.GetValueOnGameThread()))
+	{
+		return ESkateSignificance::Full;
+	}
+
+	return DistanceSq <= FMath::Square(CVarSignificanceReducedRadius.GetValueOnGameThread())
+		? ESkateSignificance::Reduced
+		: ESkateSignificance::Dormant;
+}
+
+ESkateSignificance USkateSignificanceSubsystem::ClassifyLocation(const FVector& Location, const FVector& ViewLocation, const FVector& ViewDirection) const
+{
+	const FVector ToLocation = Location - ViewLocation;
+	const float DistanceSq = ToLocation.SizeSquared();
+
+	const float FullRadius = CVarSignificanceFullRadius.GetValueOnGameThread();
+	if (DistanceSq <= FMath::Square(FullRadius))
+	{
+		return ESkateSignificance::Full;
+	}
+
+	// Things ahead of the camera stay relevant for longer than things we have already skated past
+	const float Distance = FMath::Sqrt(DistanceSq);
+	const float Facing = FVector::DotProduct(ToLocation / Distance, ViewDirection);
+	const float ViewScale = FMath::Lerp(CVarSignificanceBehindScale.GetValueOnGameThread(), 1.0f, FMath::Clamp(Facing * 0.5f + 0.5f, 0.0f, 1.0f));
+
+	return Distance * ViewScale <= CVarSignificanceReducedRadius.GetValueOnGameThread()
+		? ESkateSignificance::Reduced
+		: ESkateSignificance::Dormant;
+}
+
+void USkateSignificanceSubsystem::UpdateSignificance()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateSignificanceUpdate);
+
+	const bool bEnabled = CVarSignificanceEnabled.GetValueOnGameThread();
+
+	// Obstacle collision follows whichever skater is nearest, so a server keeps scoring skaters no local player can see
+	TArray<FVector, TInlineAllocator<8>> SkaterLocations;
+	for (const FSkaterEntry& Entry : Skaters)
+	{
+		if (const ASkateboardSimCharacter* Skater = Entry.Skater.Get())
+		{
+			SkaterLocations.Add(Skater->GetActorLocation());
+		}
+	}
+
+	uint32 NumFull = 0;
+	uint32 NumReduced = 0;
+	uint32 NumDormant = 0;
+	uint32 NumChanges = 0;
+
+	for (FObstacleEntry& Entry : Obstacles)
+	{
+		AObstacleActor* Obstacle = Entry.Obstacle.Get();
+		if (!Obstacle)
+		{
+			continue;
+		}
+
+		float NearestDistanceSq = TNumericLimits<float>::Max();
+		for (const FVector& SkaterLocation : SkaterLocations)
+		{
+			NearestDistanceSq = FMath::Min(NearestDistanceSq, (float)FVector::DistSquared(Entry.Location, SkaterLocation));
+		}
+
+		const ESkateSignificance NewSignificance = bEnabled
+			? ClassifyDistance(NearestDistanceSq)
+			: ESkateSignificance::Full;
+
+		// Only touch the collision state on transitions, toggling it is not free
+		if (NewSignificance != Entry.Significance)
+		{
+			Entry.Significance = NewSignificance;
+			Obstacle->SetSignificance(NewSignificance);
+			++NumChanges;
+		}
+
+		switch (NewSignificance)
+		{
+		case ESkateSignificance::Full:		++NumFull;		break;
+		case ESkateSignificance::Reduced:	++NumReduced;	break;
+		default:							++NumDormant;	break;
+		}
+	}
+
+	// Remote skaters only have their tick throttled, and only against a local view; a dedicated server has none
+	FVector ViewLocation = FVector::ZeroVector;
+	FVector ViewDirection = FVector::ForwardVector;
+	bool bHasLocalView = false;
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController && PlayerController->IsLocalController())
+	{
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		ViewDirection = ViewRotation.Vector();
+		bHasLocalView = true;
+
+		// Rank from the local skater rather than the camera so the arm length does not shift the rings
+		if (const APawn* LocalPawn = PlayerController->GetPawn())
+		{
+			ViewLocation = LocalPawn->GetActorLocation();
+		}
+	}
+
+	for (FSkaterEntry& Entry : Skaters)
+	{
+		ASkateboardSimCharacter* Skater = Entry.Skater.Get();
+		if (!Skater)
+		{
+			continue;
+		}
+
+		// Locally controlled skaters are what the player is driving and always stay at full rate
+		const ESkateSignificance NewSignificance = (bEnabled && bHasLocalView && !Skater->IsLocallyControlled())
+			? ClassifyLocation(Skater->GetActorLocation(), ViewLocation, ViewDirection)
+			: ESkateSignificance::Full;
+
+		if (NewSignificance != Entry.Significance)
+		{
+			Entry.Significance = NewSignificance;
+			Skater->SetSignificance(NewSignificance);
+			++NumChanges;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SkateObstaclesFull, NumFull);
+	SET_DWORD_STAT(STAT_SkateObstaclesReduced, NumReduced);
+	SET_DWORD_STAT(STAT_SkateObstaclesDormant, NumDormant);
+	SET_DWORD_STAT(STAT_SkateSignificanceChanges, NumChanges);
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SkateSignificanceSubsystem.generated.h"
+
+class AObstacleActor;
+class ASkateboardSimCharacter;
+
+/** How much work an actor is allowed to do, ranked by distance to the skaters */
+UENUM(BlueprintType)
+enum class ESkateSignificance : uint8
+{
+	Full,		// Closest ring: full tick rate and overlap generation
+	Reduced,	// Mid ring: throttled tick, no overlap generation
+	Dormant		// Far away or idle: asleep until it comes back into range
+};
+
+/**
+ * Ranks obstacles by distance to the nearest skater and scales their collision work accordingly,
+ * and throttles remote skaters' ticks by distance and view relevance to the local skater.
+ * Only the closest ring does full work.
+ */
+UCLASS()
+class SKATEBOARDSIM_API USkateSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Deinitialize() override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterObstacle(AObstacleActor* Obstacle);
+	void UnregisterObstacle(AObstacleActor* Obstacle);
+
+	void RegisterSkater(ASkateboardSimCharacter* Skater);
+	void UnregisterSkater(ASkateboardSimCharacter* Skater);
+
+	/** Forces a full re-evaluation on the next tick (e.g. after a teleport or respawn) */
+	void RequestUpdate() { TimeSinceUpdate = TNumericLimits<float>::Max(); }
+
+private:
+	struct FObstacleEntry
+	{
+		TWeakObjectPtr<AObstacleActor> Obstacle;
+		FVector Location;
+		ESkateSignificance Significance;
+	};
+
+	struct FSkaterEntry
+	{
+		TWeakObjectPtr<ASkateboardSimCharacter> Skater;
+		ESkateSignificance Significance;
+	};
+
+	void UpdateSignificance();
+
+	/** Buckets a squared distance to the nearest skater into a significance ring */
+	ESkateSignificance ClassifyDistance(float DistanceSq) const;
+
+	/** Buckets a location into a significance ring relative to the viewer, scaled by view relevance */
+	ESkateSignificance ClassifyLocation(const FVector& Location, const FVector& ViewLocation, const FVector& ViewDirection) const;
+
+	TArray<FObstacleEntry> Obstacles;
+	TMap<const AObstacleActor*, int32> ObstacleIndices;	// Keeps unregister O(1) for large parks
+
+	TArray<FSkaterEntry> Skaters;
+
+	float TimeSinceUpdate = TNumericLimits<float>::Max();
+};
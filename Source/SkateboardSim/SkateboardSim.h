@@ -3,3 +3,6 @@
 #pragma once
 
 #include "CoreMinimal.h"
+
+/** Stat group for the skate park runtime systems (stat SkateboardSim) */
+DECLARE_STATS_GROUP(TEXT("SkateboardSim"), STATGROUP_SkateboardSim, STATCAT_Advanced);
@@ -13,6 +13,8 @@
 #include <Kismet/GameplayStatics.h>
 #include "ObstacleActor.h"
 #include "ObstacleCollisionManager.h"
+#include "SkateSignificanceSubsystem.h"
+#include "SkateCameraComponent.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
@@ -42,10 +44,11 @@ ASkateboardSimCharacter::ASkateboardSimCharacter()
 	GetCharacterMovement()->BrakingDecelerationWalking = 2000.f;
 	GetCharacterMovement()->BrakingDecelerationFalling = 1500.0f;
 
-	// Create a camera boom (pulls in towards the player if there is a collision)
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
+	// Create a camera boom (pulls in towards the player if there is a collision, and opens up with speed and airtime)
+	USkateCameraComponent* SkateCamera = CreateDefaultSubobject<USkateCameraComponent>(TEXT("CameraBoom"));
+	SkateCamera->SlowArmLength = 400.0f; // The camera follows at this distance behind the character at low speed, TargetArmLength is driven from it
+	CameraBoom = SkateCamera;
 	CameraBoom->SetupAttachment(RootComponent);
-	CameraBoom->TargetArmLength = 400.0f; // The camera follows at this distance behind the character	
 	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
 
 	// Create a follow camera
@@ -67,11 +70,14 @@ ASkateboardSimCharacter::ASkateboardSimCharacter()
 
 	bIsPushing = false;									// Initialize pushing state
 	bIsBraking = false;									// Initialize braking state
+	bCanSleepTick = false;								// Decided in BeginPlay once the Blueprint class is known
 
 	/** Scoring */
 	TotalScore = 0;										// Total score of the player
 	ObstacleHitPenalty = 5.0f;							// Penalty for hitting obstacles
 	ObstacleJumpReward = 10.0f;							// Reward for successfully jumping over obstacles
+
+	ObstacleCollisionManager = nullptr;					// Found in BeginPlay
 }
 
 void ASkateboardSimCharacter::BeginPlay()
@@ -97,6 +103,9 @@ void ASkateboardSimCharacter::BeginPlay()
 	if (FoundManagers.Num() > 0)
 	{
 		ObstacleCollisionManager = Cast<AObstacleCollisionManager>(FoundManagers[0]);
+
+		// Baked obstacles have no overlap events, the manager scores them against registered skaters
+		ObstacleCollisionManager->RegisterSkater(this);
 		
 		// Find all ObstacleActor instances and assign the collision manager
 		TArray<AActor*> FoundObstacles;
@@ -115,6 +124,30 @@ void ASkateboardSimCharacter::BeginPlay()
 	{
 		UE_LOG(LogTemp, Warning, TEXT("No ObstacleCollisionManager found in the level."));
 	}
+
+	if (USkateSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<USkateSignificanceSubsystem>())
+	{
+		Significance->RegisterSkater(this);
+	}
+
+	// A Blueprint Event Tick still needs every frame, only sleep when Tick is purely ours
+	bCanSleepTick = !GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(ASkateboardSimCharacter, ReceiveTick));
+	RefreshSpeedTick();
+}
+
+void ASkateboardSimCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ObstacleCollisionManager)
+	{
+		ObstacleCollisionManager->UnregisterSkater(this);
+	}
+
+	if (USkateSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<USkateSignificanceSubsystem>())
+	{
+		Significance->UnregisterSkater(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ASkateboardSimCharacter::Tick(float DeltaTime)
@@ -247,11 +280,13 @@ void ASkateboardSimCharacter::SetPushingState()
 void ASkateboardSimCharacter::StartBraking()
 {
 		bIsBraking = true;
+		RefreshSpeedTick();
 }
 
 void ASkateboardSimCharacter::StopBraking()
 {
 	bIsBraking = false;
+	RefreshSpeedTick();
 }
 
 
@@ -265,6 +300,31 @@ void ASkateboardSimCharacter::UpdateSpeed(float DeltaSpeed, float ourMaxSpeed)
 	CurrentSpeed += DeltaSpeed;
 	CurrentSpeed = FMath::Clamp(CurrentSpeed, 0.0f, ourMaxSpeed);
 	GetCharacterMovement()->MaxWalkSpeed = CurrentSpeed;
+	RefreshSpeedTick();
+}
+
+void ASkateboardSimCharacter::RefreshSpeedTick()
+{
+	if (bCanSleepTick)
+	{
+		// Speed only changes in Tick while braking or recovering below BaseSpeed
+		SetActorTickEnabled(bIsBraking || CurrentSpeed < BaseSpeed);
+	}
+}
+
+void ASkateboardSimCharacter::SetSignificance(ESkateSignificance Significance)
+{
+	// Remote skaters far from the local player only need coarse speed and animation updates
+	float TickInterval = 0.0f;
+	switch (Significance)
+	{
+	case ESkateSignificance::Reduced:	TickInterval = 0.1f;	break;
+	case ESkateSignificance::Dormant:	TickInterval = 0.5f;	break;
+	default:													break;
+	}
+
+	SetActorTickInterval(TickInterval);
+	GetMesh()->SetComponentTickInterval(TickInterval);
 }
 
 void ASkateboardSimCharacter::StartJumping()
@@ -296,6 +356,13 @@ void ASkateboardSimCharacter::CheckForObstaclesOnJump()
 			return;
 		}
 	}
+
+	// Baked, batched and Mass obstacles have no boxes to overlap, the manager tests them directly
+	if (ObstacleCollisionManager && ObstacleCollisionManager->IsOverlappingIndexedObstacle(this))
+	{
+		TotalScore += ObstacleJumpReward;
+		UpdateHUDScore();
+	}
 }
 
 // Subtract points for failing obstacles
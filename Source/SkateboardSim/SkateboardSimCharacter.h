@@ -13,6 +13,7 @@ class UInputMappingContext;
 class UInputAction;
 struct FInputActionValue;
 class AObstacleCollisionManager;
+enum class ESkateSignificance : uint8;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
@@ -66,6 +67,9 @@ private:
 	float BrakeRate;						//Rate of Speed Decrement per brake;
 	float SpeedRecoveryRate;				//Rate of Speed Recovery after brake
 
+	/** True when nothing but our own speed logic runs in Tick, so it can sleep while speed is steady */
+	bool bCanSleepTick;
+
 	/** Timer Handles */
 	FTimerHandle SpeedResetTimerHandle;		//Resetting Speed
 	FTimerHandle BrakeResetTimerHandle;		// Resetting Brakes
@@ -119,6 +123,9 @@ protected:
 
 	void UpdateHUDScore();
 
+	/** Wakes Tick only while braking or recovering speed */
+	void RefreshSpeedTick();
+
 
 	// Reference to the obstacle collision manager
 	AObstacleCollisionManager* ObstacleCollisionManager;
@@ -130,6 +137,8 @@ protected:
 	// To add mapping context
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	void Tick(float DeltaTime);
 
 public:
@@ -138,6 +147,9 @@ public:
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
+	/** Throttles remote skaters based on how relevant they are to the local player */
+	void SetSignificance(ESkateSignificance Significance);
+
 	
 };
 